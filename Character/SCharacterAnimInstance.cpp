@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCharacterAnimInstance.h"
+#include "SCharacterBase.h"
+#include "SWeapon.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "SCharacterStats.h"
+#include "SWeaponStats.h"
+
+/** The longest step the recoil spring is integrated over, longer frames are split so a hitch can't make it explode */
+static const float MaxRecoilStep = 1.f / 60.f;
+
+FSCharacterAnimInstanceProxy::FSCharacterAnimInstanceProxy()
+	: FAnimInstanceProxy()
+	, RecoilRotation(FRotator::ZeroRotator)
+	, GunSocketLocation(FVector::ZeroVector)
+	, HandIKAlpha(1.f)
+	, AimOffsets(FRotator::ZeroRotator)
+	, RecoilVelocity(FRotator::ZeroRotator)
+	, PendingRecoilImpulse(FRotator::ZeroRotator)
+	, RecoilStiffness(1.f)
+	, RecoilDampingRatio(1.f)
+	, MaxRecoilAngle(0.f)
+	, ActorTransform(FTransform::Identity)
+	, BaseAimRotation(FRotator::ZeroRotator)
+	, bHasGunSocket(false)
+	, WeaponComponentTransform(FTransform::Identity)
+	, GunSocketBoneTransform(FTransform::Identity)
+	, GunSocketSkeletalMesh(nullptr)
+	, GunSocketName(NAME_None)
+	, GunSocketBoneIndex(INDEX_NONE)
+	, GunSocketLocalTransform(FTransform::Identity)
+{
+}
+
+FSCharacterAnimInstanceProxy::FSCharacterAnimInstanceProxy(UAnimInstance* InAnimInstance)
+	: FAnimInstanceProxy(InAnimInstance)
+	, RecoilRotation(FRotator::ZeroRotator)
+	, GunSocketLocation(FVector::ZeroVector)
+	, HandIKAlpha(1.f)
+	, AimOffsets(FRotator::ZeroRotator)
+	, RecoilVelocity(FRotator::ZeroRotator)
+	, PendingRecoilImpulse(FRotator::ZeroRotator)
+	, RecoilStiffness(1.f)
+	, RecoilDampingRatio(1.f)
+	, MaxRecoilAngle(0.f)
+	, ActorTransform(FTransform::Identity)
+	, BaseAimRotation(FRotator::ZeroRotator)
+	, bHasGunSocket(false)
+	, WeaponComponentTransform(FTransform::Identity)
+	, GunSocketBoneTransform(FTransform::Identity)
+	, GunSocketSkeletalMesh(nullptr)
+	, GunSocketName(NAME_None)
+	, GunSocketBoneIndex(INDEX_NONE)
+	, GunSocketLocalTransform(FTransform::Identity)
+{
+}
+
+void FSCharacterAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	USCharacterAnimInstance* AnimInstance = CastChecked<USCharacterAnimInstance>(InAnimInstance);
+
+	PendingRecoilImpulse += AnimInstance->PendingRecoilImpulse;
+	AnimInstance->PendingRecoilImpulse = FRotator::ZeroRotator;
+
+	RecoilStiffness = AnimInstance->RecoilStiffness;
+	RecoilDampingRatio = AnimInstance->RecoilDampingRatio;
+	MaxRecoilAngle = AnimInstance->MaxRecoilAngle;
+
+	ASCharacterBase* Character = Cast<ASCharacterBase>(AnimInstance->TryGetPawnOwner());
+	if (Character)
+	{
+		ActorTransform = Character->GetActorTransform();
+		BaseAimRotation = Character->GetBaseAimRotation();
+		HandIKAlpha = Character->GetHandIKAlpha();
+	}
+
+	SnapshotGunSocket(Character ? Character->GetCurrentEquippedWeapon() : nullptr);
+}
+
+void FSCharacterAnimInstanceProxy::SnapshotGunSocket(ASWeapon* Weapon)
+{
+	USkeletalMeshComponent* WeaponMesh = Weapon ? Weapon->GetMesh() : nullptr;
+	bHasGunSocket = WeaponMesh != nullptr;
+	if (!bHasGunSocket)
+		return;
+
+	if (WeaponMesh->SkeletalMesh != GunSocketSkeletalMesh || Weapon->GetGunHandSocket() != GunSocketName)
+	{
+		GunSocketSkeletalMesh = WeaponMesh->SkeletalMesh;
+		GunSocketName = Weapon->GetGunHandSocket();
+
+		// A missing socket falls back to the component's location, like GetSocketLocation()
+		const USkeletalMeshSocket* Socket = WeaponMesh->GetSocketByName(GunSocketName);
+		GunSocketBoneIndex = Socket ? WeaponMesh->GetBoneIndex(Socket->BoneName) : INDEX_NONE;
+		GunSocketLocalTransform = Socket ? Socket->GetSocketLocalTransform() : FTransform::Identity;
+	}
+
+	const TArray<FTransform>& ComponentSpaceTransforms = WeaponMesh->GetComponentSpaceTransforms();
+	GunSocketBoneTransform = ComponentSpaceTransforms.IsValidIndex(GunSocketBoneIndex) ? ComponentSpaceTransforms[GunSocketBoneIndex] : FTransform::Identity;
+	WeaponComponentTransform = WeaponMesh->GetComponentTransform();
+}
+
+void FSCharacterAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	UpdateRecoil(DeltaSeconds);
+	UpdateAim();
+}
+
+void FSCharacterAnimInstanceProxy::UpdateAim()
+{
+	SCOPE_CHARACTER_CYCLE_COUNTER(STAT_CharacterAimUpdate);
+
+	GunSocketLocation = bHasGunSocket ? (GunSocketLocalTransform * GunSocketBoneTransform * WeaponComponentTransform).GetLocation() : FVector::ZeroVector;
+
+	const FVector AimDirLS = ActorTransform.InverseTransformVectorNoScale(BaseAimRotation.Vector());
+	AimOffsets = AimDirLS.Rotation();
+}
+
+void FSCharacterAnimInstanceProxy::UpdateRecoil(float DeltaSeconds)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponRecoilUpdate);
+
+	RecoilVelocity += PendingRecoilImpulse;
+	PendingRecoilImpulse = FRotator::ZeroRotator;
+
+	// Nothing to do once the spring has come to rest
+	if (RecoilVelocity.IsNearlyZero(KINDA_SMALL_NUMBER) && RecoilRotation.IsNearlyZero(KINDA_SMALL_NUMBER))
+	{
+		RecoilVelocity = FRotator::ZeroRotator;
+		RecoilRotation = FRotator::ZeroRotator;
+		return;
+	}
+
+	const float Damping = 2.f * RecoilDampingRatio * FMath::Sqrt(RecoilStiffness);
+
+	// Semi-implicit Euler, stable for the stiffness a recoil spring needs at these step sizes
+	float TimeLeft = DeltaSeconds;
+	while (TimeLeft > 0.f)
+	{
+		const float Step = FMath::Min(TimeLeft, MaxRecoilStep);
+		TimeLeft -= Step;
+
+		RecoilVelocity.Pitch += (-RecoilStiffness * RecoilRotation.Pitch - Damping * RecoilVelocity.Pitch) * Step;
+		RecoilVelocity.Yaw += (-RecoilStiffness * RecoilRotation.Yaw - Damping * RecoilVelocity.Yaw) * Step;
+
+		RecoilRotation.Pitch = FMath::Clamp(RecoilRotation.Pitch + RecoilVelocity.Pitch * Step, -MaxRecoilAngle, MaxRecoilAngle);
+		RecoilRotation.Yaw = FMath::Clamp(RecoilRotation.Yaw + RecoilVelocity.Yaw * Step, -MaxRecoilAngle, MaxRecoilAngle);
+	}
+}
+
+USCharacterAnimInstance::USCharacterAnimInstance()
+{
+	RecoilStiffness = 300.f;
+	RecoilDampingRatio = 0.7f;
+	MaxRecoilAngle = 12.f;
+
+	PendingRecoilImpulse = FRotator::ZeroRotator;
+}
+
+void USCharacterAnimInstance::AddRecoilImpulse(const FRotator& Impulse)
+{
+	PendingRecoilImpulse += Impulse;
+}
+
+FAnimInstanceProxy* USCharacterAnimInstance::CreateAnimInstanceProxy()
+{
+	return &Proxy;
+}
+
+void USCharacterAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	// Proxy is a member, there is nothing to free
+}
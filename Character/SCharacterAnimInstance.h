@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "SCharacterAnimInstance.generated.h"
+
+class ASWeapon;
+class USCharacterAnimInstance;
+class USkeletalMesh;
+
+/**
+* The part of USCharacterAnimInstance that is updated on animation worker threads
+* PreUpdate() copies in the shot impulses and a snapshot of the character and its weapon, Update() integrates the recoil spring and works out the hand IK target and aim offsets
+* The anim graph reads everything it needs from here, so none of it has to call back into the character on the game thread
+*/
+USTRUCT(meta = (DisplayName = "Native Variables"))
+struct COOPHORDE_API FSCharacterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+
+	FSCharacterAnimInstanceProxy();
+
+	FSCharacterAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+	/** The pitch and yaw the recoil currently adds to the upper body, applied as an additive bone rotation by the anim graph */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Recoil)
+	FRotator RecoilRotation;
+
+	/** World location of the equipped weapon's gun hand socket, the left hand IK target */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = IK)
+	FVector GunSocketLocation;
+
+	/** The character's HandIKAlpha */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = IK)
+	float HandIKAlpha;
+
+	/** The aim rotation relative to the character, as returned by ASCharacterBase::GetAimOffsets() */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Aim)
+	FRotator AimOffsets;
+
+protected:
+
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	virtual void Update(float DeltaSeconds) override;
+
+	/** Copies the transforms the gun hand socket is worked out from, looking the socket up again only when the weapon's mesh changes. Game thread only */
+	void SnapshotGunSocket(ASWeapon* Weapon);
+
+	/** Integrates the recoil spring */
+	void UpdateRecoil(float DeltaSeconds);
+
+	/** Works out GunSocketLocation and AimOffsets from the snapshot */
+	void UpdateAim();
+
+	/** Angular velocity of the recoil in degrees per second */
+	FRotator RecoilVelocity;
+
+	/** Velocity added by the shots since the last update */
+	FRotator PendingRecoilImpulse;
+
+	/** Copied from the anim instance every update */
+	float RecoilStiffness;
+	float RecoilDampingRatio;
+	float MaxRecoilAngle;
+
+	/** Snapshot of the character */
+	FTransform ActorTransform;
+	FRotator BaseAimRotation;
+
+	/** Whether there was a weapon with a mesh to snapshot */
+	bool bHasGunSocket;
+
+	/** Snapshot of the weapon mesh and its gun hand socket's bone, in world and component space */
+	FTransform WeaponComponentTransform;
+	FTransform GunSocketBoneTransform;
+
+	/** The skeletal mesh and socket name the cached socket was looked up for, only compared against */
+	const USkeletalMesh* GunSocketSkeletalMesh;
+	FName GunSocketName;
+
+	/** The cached socket's bone, and its offset from it */
+	int32 GunSocketBoneIndex;
+	FTransform GunSocketLocalTransform;
+};
+
+/**
+* Native base of the character AnimBP
+* Recoil is a spring-damper kicked by shot impulses instead of a montage per shot, so firing creates no montage instances
+*/
+UCLASS(Transient, Blueprintable)
+class COOPHORDE_API USCharacterAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+
+	USCharacterAnimInstance();
+
+	/** How strongly the recoil is pulled back to rest */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Recoil, meta = (ClampMin = 1.f))
+	float RecoilStiffness;
+
+	/** 1 returns to rest as fast as possible without overshooting, lower values overshoot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Recoil, meta = (ClampMin = 0.f))
+	float RecoilDampingRatio;
+
+	/** The furthest in degrees the recoil can rotate on either axis */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Recoil, meta = (ClampMin = 0.f))
+	float MaxRecoilAngle;
+
+	/** Kicks the recoil by Impulse, in degrees per second. Game thread only */
+	void AddRecoilImpulse(const FRotator& Impulse);
+
+protected:
+
+	/** Owned by the anim instance rather than allocated, so the anim graph can read it directly */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Proxy, meta = (AllowPrivateAccess = "true"))
+	FSCharacterAnimInstanceProxy Proxy;
+
+	/** Impulses added since the proxy last took them */
+	FRotator PendingRecoilImpulse;
+
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+
+	friend struct FSCharacterAnimInstanceProxy;
+};
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCharacterMovementComponent.h"
+#include "SCharacterBase.h"
+
+void FSSavedMove_Character::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToSprint = false;
+	bSavedWantsToAimDownSights = false;
+	bSavedWantsToFire = false;
+}
+
+uint8 FSSavedMove_Character::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bSavedWantsToSprint)
+	{
+		Result |= FLAG_Custom_0;
+	}
+
+	if (bSavedWantsToAimDownSights)
+	{
+		Result |= FLAG_Custom_1;
+	}
+
+	if (bSavedWantsToFire)
+	{
+		Result |= FLAG_Custom_2;
+	}
+
+	return Result;
+}
+
+bool FSSavedMove_Character::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSSavedMove_Character* NewSMove = static_cast<const FSSavedMove_Character*>(NewMove.Get());
+
+	if (bSavedWantsToSprint != NewSMove->bSavedWantsToSprint
+		|| bSavedWantsToAimDownSights != NewSMove->bSavedWantsToAimDownSights
+		|| bSavedWantsToFire != NewSMove->bSavedWantsToFire)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSSavedMove_Character::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	USCharacterMovementComponent* MovementComp = Cast<USCharacterMovementComponent>(Character->GetCharacterMovement());
+	if (MovementComp)
+	{
+		bSavedWantsToSprint = MovementComp->bWantsToSprint;
+		bSavedWantsToAimDownSights = MovementComp->bWantsToAimDownSights;
+		bSavedWantsToFire = MovementComp->bWantsToFire;
+	}
+}
+
+void FSSavedMove_Character::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	USCharacterMovementComponent* MovementComp = Cast<USCharacterMovementComponent>(Character->GetCharacterMovement());
+	if (MovementComp)
+	{
+		MovementComp->bWantsToSprint = bSavedWantsToSprint;
+		MovementComp->bWantsToAimDownSights = bSavedWantsToAimDownSights;
+		MovementComp->bWantsToFire = bSavedWantsToFire;
+	}
+}
+
+FSNetworkPredictionData_Client_Character::FSNetworkPredictionData_Client_Character(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FSNetworkPredictionData_Client_Character::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSSavedMove_Character());
+}
+
+USCharacterMovementComponent::USCharacterMovementComponent()
+{
+	MaxWalkSpeed = 400.f;
+	MaxWalkSpeedCrouched = 250.f;
+	MaxSprintSpeed = 600.f;
+
+	// Changing this value to 0.1 allows for diagonal sprinting. (holding W+A or W+D keys)
+	SprintDirectionMinDot = 0.8f;
+
+	NavAgentProps.bCanCrouch = true;
+
+	bWantsToSprint = false;
+	bWantsToAimDownSights = false;
+	bWantsToFire = false;
+}
+
+bool USCharacterMovementComponent::IsSprinting() const
+{
+	// Don't allow sprint while strafing sideways or standing still (1.0 is straight forward, -1.0 is backward while near 0 is sideways or standing still)
+	return bWantsToSprint && !bWantsToAimDownSights && !Velocity.IsZero() && UpdatedComponent
+		&& FVector::DotProduct(Velocity.GetSafeNormal2D(), UpdatedComponent->GetForwardVector()) > SprintDirectionMinDot;
+}
+
+float USCharacterMovementComponent::GetMaxSpeed() const
+{
+	if (MovementMode == MOVE_Walking && !IsCrouching() && IsSprinting())
+	{
+		return MaxSprintSpeed;
+	}
+
+	return Super::GetMaxSpeed();
+}
+
+FNetworkPredictionData_Client* USCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		USCharacterMovementComponent* MutableThis = const_cast<USCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FSNetworkPredictionData_Client_Character(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void USCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToAimDownSights = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+	bWantsToFire = (Flags & FSavedMove_Character::FLAG_Custom_2) != 0;
+
+	ASCharacterBase* Character = Cast<ASCharacterBase>(CharacterOwner);
+	if (Character && Character->HasAuthority())
+	{
+		Character->ApplyMovementFlags(bWantsToSprint, bWantsToAimDownSights, bWantsToFire);
+	}
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "SCharacterMovementComponent.generated.h"
+
+/**
+* A saved move that also remembers whether the character wanted to sprint, aim down sights and fire
+*/
+class FSSavedMove_Character : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	/** The character wanted to sprint during the move */
+	uint8 bSavedWantsToSprint : 1;
+
+	/** The character was aiming down sights during the move */
+	uint8 bSavedWantsToAimDownSights : 1;
+
+	/** The character was firing during the move */
+	uint8 bSavedWantsToFire : 1;
+
+	virtual void Clear() override;
+
+	virtual uint8 GetCompressedFlags() const override;
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+
+	virtual void PrepMoveFor(ACharacter* Character) override;
+};
+
+/**
+* Client prediction data that saves FSSavedMove_Character moves
+*/
+class FSNetworkPredictionData_Client_Character : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FSNetworkPredictionData_Client_Character(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+/**
+* Sends sprint, aim down sights and firing with every move as compressed flags instead of their own server RPCs
+* The max speed is derived from the flags on the client and the server alike, so changing it never causes a correction
+*/
+UCLASS()
+class COOPHORDE_API USCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	USCharacterMovementComponent();
+
+	/** The max speed when sprinting */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Character Movement: Walking", meta = (ClampMin = "0", UIMin = "0"))
+	float MaxSprintSpeed;
+
+	/** The velocity must point at least this close to the character's forward vector to sprint, 1 is straight forward */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Character Movement: Walking", meta = (ClampMin = "-1", ClampMax = "1"))
+	float SprintDirectionMinDot;
+
+	/** Whether the character wants to sprint */
+	uint8 bWantsToSprint : 1;
+
+	/** Whether the character is aiming down sights */
+	uint8 bWantsToAimDownSights : 1;
+
+	/** Whether the character is firing */
+	uint8 bWantsToFire : 1;
+
+	/** Whether the character is sprinting, wanting to while moving forward and not aiming down sights */
+	bool IsSprinting() const;
+
+	virtual float GetMaxSpeed() const override;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+
+	/** Reads the flags on the server, and passes them on to the owner so they replicate to everyone else */
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+};
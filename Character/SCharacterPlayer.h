@@ -1,86 +1,103 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "SCharacterBase.h"
-#include "SCharacterPlayer.generated.h"
-
-class UCameraComponent;
-class USpringArmComponent;
-class AWeaponPickup;
-
-UCLASS()
-class COOPHORDE_API ASCharacterPlayer : public ASCharacterBase
-{
-	GENERATED_BODY()
-	
-public:
-
-	ASCharacterPlayer();
-
-protected:
-
-	/** The cameras field of view when not aiming down sights */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = ADS)
-	float DefaultFOV;
-
-	/** The cameras field of view when aiming down sights */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = ADS)
-	float AimDownSightFOV;
-
-	/** The third person camera */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
-	UCameraComponent* CameraComp;
-
-	/** The third person camera spring arm */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
-	USpringArmComponent* SpringArmComp;
-
-	UPROPERTY(Replicated)
-	ASWeapon* OverlappingWeaponPickup;
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-	/** Adds movement in the forward direction */
-	void MoveForward(float Value);
-
-	/** Adds movement in the right direction */
-	void MoveRight(float Value);
-
-	virtual void SetWantsToSprint(bool WantsToSprint) override;
-
-	virtual void SetAimingDownSights(bool NewAimingDownSight) override;
-
-	/** Updates the Crosshair depending on the state of bIsADS */
-	UFUNCTION(BlueprintImplementableEvent)
-	void UpdateCrosshairADS(bool bIsADS);
-
-	/** Updates the Crosshair depending on the state of bIsSprinting */
-	UFUNCTION(BlueprintImplementableEvent)
-	void UpdateCrosshairSprinting(bool bIsSprinting);
-
-public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	// Called to bind functionality to input
-	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
-
-	/** Returns the location of the Camera Component */
-	virtual FVector GetPawnViewLocation() const override;
-
-	void SetOverlappingWeaponPickup(ASWeapon* WeaponPickup);
-
-	void RemoveOverlappingWeaponPickup(ASWeapon* WeaponPickup);
-
-	void Interact();
-
-	UFUNCTION(Server, Reliable)
-	void ServerInteract();
-
-	UFUNCTION(BlueprintImplementableEvent)
-	void OnOverlapUI(bool bShowUI, FName WeaponName);
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SCharacterBase.h"
+#include "SCharacterPlayer.generated.h"
+
+class UCameraComponent;
+class USpringArmComponent;
+class AWeaponPickup;
+struct FSGroundItem;
+
+UCLASS()
+class COOPHORDE_API ASCharacterPlayer : public ASCharacterBase
+{
+	GENERATED_BODY()
+	
+public:
+
+	ASCharacterPlayer(const FObjectInitializer& ObjectInitializer);
+
+protected:
+
+	/** The cameras field of view when not aiming down sights */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = ADS)
+	float DefaultFOV;
+
+	/** The cameras field of view when aiming down sights */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = ADS)
+	float AimDownSightFOV;
+
+	/** The third person camera */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	UCameraComponent* CameraComp;
+
+	/** The third person camera spring arm */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	USpringArmComponent* SpringArmComp;
+
+	/** The ground item the player is standing next to, only known by the server */
+	int32 OverlappingGroundItemId;
+
+	/** The weapon class of OverlappingGroundItemId, replicated to the owner to show the pickup UI */
+	UPROPERTY(ReplicatedUsing = OnRep_OverlappingGroundItemClass)
+	TSubclassOf<ASWeapon> OverlappingGroundItemClass;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	/** Adds movement in the forward direction */
+	void MoveForward(float Value);
+
+	/** Adds movement in the right direction */
+	void MoveRight(float Value);
+
+	virtual void SetWantsToSprint(bool WantsToSprint) override;
+
+	virtual void SetAimingDownSights(bool NewAimingDownSight) override;
+
+	/** Whether Tick() has anything to do, only while the camera FOV is changing */
+	bool NeedsTick() const;
+
+	/** Enables Tick() only while NeedsTick() */
+	void UpdateTickEnabled();
+
+	/** Returns the FOV the camera is changing to */
+	float GetTargetFOV() const;
+
+	/** Updates the Crosshair depending on the state of bIsADS */
+	UFUNCTION(BlueprintImplementableEvent)
+	void UpdateCrosshairADS(bool bIsADS);
+
+	/** Updates the Crosshair depending on the state of bIsSprinting */
+	UFUNCTION(BlueprintImplementableEvent)
+	void UpdateCrosshairSprinting(bool bIsSprinting);
+
+	/** Shows or hides the pickup UI for OverlappingGroundItemClass */
+	UFUNCTION()
+	void OnRep_OverlappingGroundItemClass();
+
+public:
+	// Called while NeedsTick()
+	virtual void Tick(float DeltaTime) override;
+
+	// Called to bind functionality to input
+	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+
+	/** Returns the location of the Camera Component */
+	virtual FVector GetPawnViewLocation() const override;
+
+	/** Called by the ground item subsystem on the server with the closest item to the player, or null. Takes the ammo of a weapon the player already carries */
+	void SetOverlappingGroundItem(const FSGroundItem* GroundItem);
+
+	void Interact();
+
+	UFUNCTION(Server, Reliable)
+	void ServerInteract();
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnOverlapUI(bool bShowUI, FName WeaponName);
+};
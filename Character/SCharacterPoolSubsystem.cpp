@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCharacterPoolSubsystem.h"
+#include "SCharacterBase.h"
+#include "SCharacterStats.h"
+
+static int32 CharacterPoolEnabled = 1;
+FAutoConsoleVariableRef CVARCharacterPoolEnabled(
+	TEXT("COOP.CharacterPool"),
+	CharacterPoolEnabled,
+	TEXT("Reuse dead characters instead of destroying them and spawning new ones"),
+	ECVF_Default);
+
+static int32 CharacterPoolMaxFree = 32;
+FAutoConsoleVariableRef CVARCharacterPoolMaxFree(
+	TEXT("COOP.CharacterPoolMaxFree"),
+	CharacterPoolMaxFree,
+	TEXT("The most free characters kept per class, characters released past this are destroyed"),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdCharacterPoolStats(
+	TEXT("COOP.CharacterPoolStats"),
+	TEXT("Logs the free, spawned, acquired, reused, released and prewarmed characters of each pooled character class"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		USCharacterPoolSubsystem* CharacterPool = World ? World->GetSubsystem<USCharacterPoolSubsystem>() : nullptr;
+		if (CharacterPool)
+		{
+			CharacterPool->LogStats();
+		}
+	}));
+
+void USCharacterPoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &USCharacterPoolSubsystem::OnWorldInitializedActors);
+}
+
+void USCharacterPoolSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+
+	for (const TPair<UClass*, FSCharacterPool>& Pool : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_CharacterPooledCharacters, Pool.Value.FreeCharacters.Num());
+	}
+	Pools.Reset();
+
+	Super::Deinitialize();
+}
+
+ASCharacterBase* USCharacterPoolSubsystem::AcquireCharacter(TSubclassOf<ASCharacterBase> CharacterClass, const FTransform& Transform)
+{
+	UWorld* World = GetWorld();
+	if (CharacterClass == nullptr || World->GetNetMode() == NM_Client)
+		return nullptr;
+
+	FSCharacterPool& Pool = Pools.FindOrAdd(CharacterClass);
+	Pool.NumAcquired++;
+
+	while (Pool.FreeCharacters.Num() > 0)
+	{
+		ASCharacterBase* Character = Pool.FreeCharacters.Pop(false);
+		DEC_DWORD_STAT(STAT_CharacterPooledCharacters);
+
+		// Destroyed by something else while it was pooled
+		if (Character == nullptr || Character->IsPendingKillPending())
+			continue;
+
+		Pool.NumReused++;
+
+		Character->SetIsPooled(false);
+		Character->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+		Character->SetActorEnableCollision(true);
+		Character->SetActorHiddenInGame(false);
+		Character->ReuseFromPool();
+
+		return Character;
+	}
+
+	return SpawnCharacter(CharacterClass, Transform);
+}
+
+void USCharacterPoolSubsystem::ReleaseCharacter(ASCharacterBase* Character)
+{
+	if (Character == nullptr || Character->IsPooled() || Character->IsPendingKillPending())
+		return;
+
+	FSCharacterPool& Pool = Pools.FindOrAdd(Character->GetClass());
+	if (CharacterPoolEnabled == 0 || !Character->CanBePooled() || Pool.FreeCharacters.Num() >= CharacterPoolMaxFree)
+	{
+		Character->Destroy();
+		return;
+	}
+
+	AddToPool(Character, Pool);
+	Pool.NumReleased++;
+}
+
+void USCharacterPoolSubsystem::AddToPool(ASCharacterBase* Character, FSCharacterPool& Pool)
+{
+	Character->ResetForPool();
+
+	// Hidden without collision, so it stops being relevant to every connection
+	Character->SetActorHiddenInGame(true);
+	Character->SetActorEnableCollision(false);
+	Character->SetIsPooled(true);
+
+	Pool.FreeCharacters.Add(Character);
+	INC_DWORD_STAT(STAT_CharacterPooledCharacters);
+}
+
+void USCharacterPoolSubsystem::PrewarmCharacters(TSubclassOf<ASCharacterBase> CharacterClass, int32 Count)
+{
+	UWorld* World = GetWorld();
+	if (CharacterClass == nullptr || World == nullptr || World->GetNetMode() == NM_Client || CharacterPoolEnabled == 0)
+		return;
+
+	if (!CharacterClass->GetDefaultObject<ASCharacterBase>()->CanBePooled())
+		return;
+
+	FSCharacterPool& Pool = Pools.FindOrAdd(CharacterClass);
+	const int32 NumToSpawn = FMath::Min(Count, CharacterPoolMaxFree) - Pool.FreeCharacters.Num();
+
+	for (int32 i = 0; i < NumToSpawn; i++)
+	{
+		ASCharacterBase* Character = SpawnCharacter(CharacterClass, FTransform::Identity);
+		if (Character == nullptr)
+			break;
+
+		AddToPool(Character, Pool);
+		Pool.NumPrewarmed++;
+	}
+}
+
+void USCharacterPoolSubsystem::LogStats() const
+{
+	UE_LOG(LogCoopCharacters, Log, TEXT("Character pool is %s, %d character classes"), CharacterPoolEnabled ? TEXT("enabled") : TEXT("disabled"), Pools.Num());
+
+	for (const TPair<UClass*, FSCharacterPool>& Pool : Pools)
+	{
+		const FSCharacterPool& Stats = Pool.Value;
+		const float ReuseRate = Stats.NumAcquired > 0 ? 100.f * Stats.NumReused / Stats.NumAcquired : 0.f;
+
+		UE_LOG(LogCoopCharacters, Log, TEXT("  %s: %d free, %d spawned, %d acquired, %d reused (%.1f%%), %d released, %d prewarmed"),
+			*GetNameSafe(Pool.Key), Stats.FreeCharacters.Num(), Stats.NumSpawned, Stats.NumAcquired, Stats.NumReused, ReuseRate, Stats.NumReleased, Stats.NumPrewarmed);
+	}
+}
+
+void USCharacterPoolSubsystem::OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	if (Params.World != GetWorld())
+		return;
+
+	for (const FSCharacterPoolPrewarm& Prewarm : PrewarmClasses)
+	{
+		PrewarmCharacters(Prewarm.CharacterClass.LoadSynchronous(), Prewarm.Count);
+	}
+}
+
+ASCharacterBase* USCharacterPoolSubsystem::SpawnCharacter(TSubclassOf<ASCharacterBase> CharacterClass, const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	ASCharacterBase* Character = GetWorld()->SpawnActor<ASCharacterBase>(CharacterClass, Transform, SpawnParams);
+	if (Character)
+	{
+		Pools.FindOrAdd(CharacterClass).NumSpawned++;
+	}
+
+	return Character;
+}
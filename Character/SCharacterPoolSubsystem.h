@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/World.h"
+#include "SCharacterPoolSubsystem.generated.h"
+
+class ASCharacterBase;
+
+/**
+* A character class to spawn into the pool as the world loads
+*/
+USTRUCT()
+struct FSCharacterPoolPrewarm
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The character class to spawn */
+	UPROPERTY(Config)
+	TSoftClassPtr<ASCharacterBase> CharacterClass;
+
+	/** How many instances to spawn */
+	UPROPERTY(Config)
+	int32 Count;
+
+	FSCharacterPoolPrewarm()
+		: Count(0)
+	{}
+};
+
+/**
+* The pooled instances of one character class
+*/
+USTRUCT()
+struct FSCharacterPool
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Hidden instances ready to be handed out */
+	UPROPERTY(Transient)
+	TArray<ASCharacterBase*> FreeCharacters;
+
+	/** Instances the pool has spawned */
+	int32 NumSpawned;
+
+	/** Times an instance has been asked for */
+	int32 NumAcquired;
+
+	/** Times an instance was handed out without spawning one */
+	int32 NumReused;
+
+	/** Times an instance has been given back */
+	int32 NumReleased;
+
+	/** Instances spawned straight into the pool by PrewarmCharacters() */
+	int32 NumPrewarmed;
+
+	FSCharacterPool()
+		: NumSpawned(0)
+		, NumAcquired(0)
+		, NumReused(0)
+		, NumReleased(0)
+		, NumPrewarmed(0)
+	{}
+};
+
+/**
+* Per class pools of ASCharacterBase, so AI waves don't spawn a character and its weapons for every enemy and destroy them all again once the wave is dead
+* Dead characters whose lifespan expires are reset in place and hidden without collision, which makes clients drop them until they are handed out again
+* Clients that still have one when it is handed out stand it back up when bDied replicates as false
+* Classes listed in PrewarmClasses in the Game config are spawned on the server as the world's actors are initialized
+*/
+UCLASS(Config = Game)
+class COOPHORDE_API USCharacterPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Hands out a character of CharacterClass at Transform with its starter weapons and default controller, reusing a pooled one if there is one. Server only */
+	UFUNCTION(BlueprintCallable, Category = Character)
+	ASCharacterBase* AcquireCharacter(TSubclassOf<ASCharacterBase> CharacterClass, const FTransform& Transform);
+
+	/** Resets Character and keeps it for the next AcquireCharacter(), or destroys it when the pool is full or disabled */
+	void ReleaseCharacter(ASCharacterBase* Character);
+
+	/** Spawns characters into the pool until it holds Count free instances of CharacterClass */
+	UFUNCTION(BlueprintCallable, Category = Character)
+	void PrewarmCharacters(TSubclassOf<ASCharacterBase> CharacterClass, int32 Count);
+
+	/** Logs the pool of every class */
+	void LogStats() const;
+
+protected:
+
+	/** Character classes spawned into the pool when the world loads */
+	UPROPERTY(Config)
+	TArray<FSCharacterPoolPrewarm> PrewarmClasses;
+
+	/** The pool of each character class */
+	UPROPERTY(Transient)
+	TMap<UClass*, FSCharacterPool> Pools;
+
+	FDelegateHandle WorldInitializedActorsHandle;
+
+	/** Prewarms PrewarmClasses once the world's actors are initialized */
+	void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+
+	/** Resets Character and adds it to Pool's free characters */
+	void AddToPool(ASCharacterBase* Character, FSCharacterPool& Pool);
+
+	/** Spawns a new character of CharacterClass */
+	ASCharacterBase* SpawnCharacter(TSubclassOf<ASCharacterBase> CharacterClass, const FTransform& Transform);
+};
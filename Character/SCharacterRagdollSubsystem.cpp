@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCharacterRagdollSubsystem.h"
+#include "SCharacterBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "SCharacterStats.h"
+
+static int32 MaxRagdolls = 12;
+FAutoConsoleVariableRef CVARMaxRagdolls(
+	TEXT("COOP.MaxRagdolls"),
+	MaxRagdolls,
+	TEXT("The most dead characters simulating as ragdolls at once, characters dying past this play their death animation"),
+	ECVF_Default);
+
+static float RagdollSettleSpeed = 10.f;
+FAutoConsoleVariableRef CVARRagdollSettleSpeed(
+	TEXT("COOP.RagdollSettleSpeed"),
+	RagdollSettleSpeed,
+	TEXT("A ragdoll whose root body moves slower than this is settled and frozen"),
+	ECVF_Default);
+
+static float RagdollMinSimulateTime = 0.5f;
+FAutoConsoleVariableRef CVARRagdollMinSimulateTime(
+	TEXT("COOP.RagdollMinSimulateTime"),
+	RagdollMinSimulateTime,
+	TEXT("Seconds a ragdoll simulates before it can be frozen, so it isn't frozen before it starts falling"),
+	ECVF_Default);
+
+static float RagdollMaxSimulateTime = 5.f;
+FAutoConsoleVariableRef CVARRagdollMaxSimulateTime(
+	TEXT("COOP.RagdollMaxSimulateTime"),
+	RagdollMaxSimulateTime,
+	TEXT("Seconds after which a ragdoll is frozen even if it hasn't settled"),
+	ECVF_Default);
+
+bool USCharacterRagdollSubsystem::StartRagdoll(ASCharacterBase* Character)
+{
+	UWorld* World = GetWorld();
+	if (Character == nullptr || World->IsNetMode(NM_DedicatedServer))
+		return false;
+
+	if (Ragdolls.Num() >= MaxRagdolls)
+	{
+		INC_DWORD_STAT(STAT_CharacterRagdollsOverBudget);
+		return false;
+	}
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	Mesh->SetCollisionProfileName(TEXT("Ragdoll"));
+	Character->SetActorEnableCollision(true);
+
+	Mesh->SetAllBodiesSimulatePhysics(true);
+	Mesh->SetSimulatePhysics(true);
+	Mesh->WakeAllRigidBodies();
+	Mesh->bBlendPhysics = true;
+
+	Ragdolls.Emplace(Character, World->GetTimeSeconds());
+	INC_DWORD_STAT(STAT_CharacterSimulatingRagdolls);
+
+	return true;
+}
+
+void USCharacterRagdollSubsystem::StopRagdoll(ASCharacterBase* Character)
+{
+	const int32 Index = Ragdolls.IndexOfByPredicate([Character](const FSSimulatingRagdoll& Ragdoll) { return Ragdoll.Character == Character; });
+	if (Index == INDEX_NONE)
+		return;
+
+	Ragdolls.RemoveAtSwap(Index, 1, false);
+	DEC_DWORD_STAT(STAT_CharacterSimulatingRagdolls);
+}
+
+void USCharacterRagdollSubsystem::FreezePose(USkeletalMeshComponent* Mesh)
+{
+	if (Mesh == nullptr)
+		return;
+
+	Mesh->PutAllRigidBodiesToSleep();
+	Mesh->SetSimulatePhysics(false);
+	Mesh->SetAllBodiesSimulatePhysics(false);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	// Without a tick the bone transforms are never refreshed, so the mesh keeps the pose it has now
+	Mesh->bPauseAnims = true;
+	Mesh->SetComponentTickEnabled(false);
+}
+
+void USCharacterRagdollSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CHARACTER_CYCLE_COUNTER(STAT_CharacterRagdollUpdate);
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = Ragdolls.Num() - 1; i >= 0; i--)
+	{
+		const FSSimulatingRagdoll& Ragdoll = Ragdolls[i];
+		if (Ragdoll.Character && !IsSettled(Ragdoll, WorldTime))
+			continue;
+
+		if (Ragdoll.Character)
+		{
+			FreezePose(Ragdoll.Character->GetMesh());
+		}
+
+		Ragdolls.RemoveAtSwap(i, 1, false);
+		DEC_DWORD_STAT(STAT_CharacterSimulatingRagdolls);
+	}
+}
+
+ETickableTickType USCharacterRagdollSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool USCharacterRagdollSubsystem::IsTickable() const
+{
+	return Ragdolls.Num() > 0;
+}
+
+TStatId USCharacterRagdollSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USCharacterRagdollSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* USCharacterRagdollSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void USCharacterRagdollSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_CharacterSimulatingRagdolls, Ragdolls.Num());
+	Ragdolls.Reset();
+
+	Super::Deinitialize();
+}
+
+bool USCharacterRagdollSubsystem::IsSettled(const FSSimulatingRagdoll& Ragdoll, float WorldTime) const
+{
+	const float SimulateTime = WorldTime - Ragdoll.StartTime;
+	if (SimulateTime < RagdollMinSimulateTime)
+		return false;
+
+	if (SimulateTime > RagdollMaxSimulateTime)
+		return true;
+
+	USkeletalMeshComponent* Mesh = Ragdoll.Character->GetMesh();
+	return !Mesh->RigidBodyIsAwake() || Mesh->GetPhysicsLinearVelocity().SizeSquared() < FMath::Square(RagdollSettleSpeed);
+}
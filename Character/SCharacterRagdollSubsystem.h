@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SCharacterRagdollSubsystem.generated.h"
+
+class ASCharacterBase;
+class USkeletalMeshComponent;
+
+/**
+* A dead character whose mesh is simulating
+*/
+USTRUCT()
+struct FSSimulatingRagdoll
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The dead character */
+	UPROPERTY(Transient)
+	ASCharacterBase* Character;
+
+	/** The world time the ragdoll started simulating */
+	float StartTime;
+
+	FSSimulatingRagdoll()
+		: Character(nullptr)
+		, StartTime(0.f)
+	{}
+
+	FSSimulatingRagdoll(ASCharacterBase* InCharacter, float InStartTime)
+		: Character(InCharacter)
+		, StartTime(InStartTime)
+	{}
+};
+
+/**
+* Caps how many dead characters simulate as ragdolls at once, so a wave wipe doesn't start dozens of ragdolls on the same frame
+* Ragdolls that have settled, or simulated for COOP.RagdollMaxSimulateTime, stop simulating and hold their last pose until the character is destroyed
+* Characters dying past COOP.MaxRagdolls, or on a dedicated server, don't ragdoll at all
+*/
+UCLASS()
+class COOPHORDE_API USCharacterRagdollSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Starts Character's mesh simulating, returns false without changing it when over budget or on a dedicated server */
+	bool StartRagdoll(ASCharacterBase* Character);
+
+	/** Stops tracking Character, without freezing it */
+	void StopRagdoll(ASCharacterBase* Character);
+
+	/** Stops Mesh simulating and animating, keeping its current pose */
+	static void FreezePose(USkeletalMeshComponent* Mesh);
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+	virtual void Deinitialize() override;
+
+protected:
+
+	/** The ragdolls that are simulating */
+	UPROPERTY(Transient)
+	TArray<FSSimulatingRagdoll> Ragdolls;
+
+	/** Whether the ragdoll has stopped moving */
+	bool IsSettled(const FSSimulatingRagdoll& Ragdoll, float WorldTime) const;
+};
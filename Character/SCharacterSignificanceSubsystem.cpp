@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCharacterSignificanceSubsystem.h"
+#include "SCharacterBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "SCharacterStats.h"
+
+static int32 SignificanceEnabled = 1;
+FAutoConsoleVariableRef CVARSignificanceEnabled(
+	TEXT("COOP.Significance"),
+	SignificanceEnabled,
+	TEXT("Scale the tick rate of characters by how far they are from the players"),
+	ECVF_Default);
+
+static float SignificanceInterval = 0.25f;
+FAutoConsoleVariableRef CVARSignificanceInterval(
+	TEXT("COOP.SignificanceInterval"),
+	SignificanceInterval,
+	TEXT("Seconds between recalculating the significance of every character"),
+	ECVF_Default);
+
+static float SignificanceHighDistance = 2000.f;
+FAutoConsoleVariableRef CVARSignificanceHighDistance(
+	TEXT("COOP.SignificanceHighDistance"),
+	SignificanceHighDistance,
+	TEXT("Characters closer than this to a player view tick every frame"),
+	ECVF_Default);
+
+static float SignificanceMediumDistance = 5000.f;
+FAutoConsoleVariableRef CVARSignificanceMediumDistance(
+	TEXT("COOP.SignificanceMediumDistance"),
+	SignificanceMediumDistance,
+	TEXT("Characters closer than this to a player view have Medium significance, further ones Low"),
+	ECVF_Default);
+
+static float SignificanceLowDistance = 10000.f;
+FAutoConsoleVariableRef CVARSignificanceLowDistance(
+	TEXT("COOP.SignificanceLowDistance"),
+	SignificanceLowDistance,
+	TEXT("Characters closer than this to a player view have Low significance, further ones Lowest"),
+	ECVF_Default);
+
+/** Characters behind every player view, or not rendered, count as this much further away */
+static const float SignificanceHiddenDistanceScale = 2.f;
+
+/** The cosine of the angle from a view's direction that counts as in front of it */
+static const float SignificanceViewConeCos = 0.5f;
+
+/** Tick intervals of each ESCharacterSignificance, 0 ticks every frame */
+static const float SignificanceActorTickIntervals[] = { 0.f, 0.05f, 0.15f, 0.4f };
+static const float SignificanceMeshTickIntervals[] = { 0.f, 0.033f, 0.1f, 0.25f };
+static const float SignificanceMovementTickIntervals[] = { 0.f, 0.f, 0.05f, 0.1f };
+
+void USCharacterSignificanceSubsystem::RegisterCharacter(ASCharacterBase* Character)
+{
+	if (Character == nullptr || Characters.Contains(Character))
+		return;
+
+	Characters.Add(Character);
+	Significances.Add(ESCharacterSignificance::High);
+}
+
+void USCharacterSignificanceSubsystem::UnregisterCharacter(ASCharacterBase* Character)
+{
+	const int32 Index = Characters.IndexOfByKey(Character);
+	if (Index == INDEX_NONE)
+		return;
+
+	// Pooled characters are registered again when they are reused, so they go back to ticking every frame
+	if (Significances[Index] != ESCharacterSignificance::High && Character)
+	{
+		ApplySignificance(Character, ESCharacterSignificance::High);
+	}
+
+	Characters.RemoveAtSwap(Index, 1, false);
+	Significances.RemoveAtSwap(Index, 1, false);
+}
+
+void USCharacterSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.f)
+		return;
+
+	TimeUntilUpdate = SignificanceInterval;
+	UpdateSignificance();
+}
+
+ETickableTickType USCharacterSignificanceSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool USCharacterSignificanceSubsystem::IsTickable() const
+{
+	return Characters.Num() > 0;
+}
+
+TStatId USCharacterSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USCharacterSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* USCharacterSignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void USCharacterSignificanceSubsystem::UpdateSignificance()
+{
+	SCOPE_CHARACTER_CYCLE_COUNTER(STAT_CharacterSignificance);
+
+	UWorld* World = GetWorld();
+
+	// The view of every player on this machine, or of every player in the game on the server
+	TArray<FTransform, TInlineAllocator<8>> Views;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController == nullptr)
+			continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		Views.Emplace(ViewRotation, ViewLocation);
+	}
+
+	const bool bCanBeRendered = !World->IsNetMode(NM_DedicatedServer);
+
+	for (int32 i = 0; i < Characters.Num(); i++)
+	{
+		ASCharacterBase* Character = Characters[i];
+		if (Character == nullptr)
+			continue;
+
+		ESCharacterSignificance NewSignificance = ESCharacterSignificance::High;
+
+		if (SignificanceEnabled && !Character->IsLocallyControlled() && Views.Num() > 0)
+		{
+			const FVector Location = Character->GetActorLocation();
+			const bool bRendered = bCanBeRendered && Character->WasRecentlyRendered(SignificanceInterval);
+
+			float ClosestDistance = MAX_flt;
+			for (const FTransform& View : Views)
+			{
+				const FVector ToCharacter = Location - View.GetLocation();
+				float Distance = ToCharacter.Size();
+
+				const bool bInFront = FVector::DotProduct(View.GetRotation().GetForwardVector(), ToCharacter.GetSafeNormal()) > SignificanceViewConeCos;
+				if (!bInFront || (bCanBeRendered && !bRendered))
+				{
+					Distance *= SignificanceHiddenDistanceScale;
+				}
+
+				ClosestDistance = FMath::Min(ClosestDistance, Distance);
+			}
+
+			if (ClosestDistance > SignificanceLowDistance)
+			{
+				NewSignificance = ESCharacterSignificance::Lowest;
+			}
+			else if (ClosestDistance > SignificanceMediumDistance)
+			{
+				NewSignificance = ESCharacterSignificance::Low;
+			}
+			else if (ClosestDistance > SignificanceHighDistance)
+			{
+				NewSignificance = ESCharacterSignificance::Medium;
+			}
+		}
+
+		if (NewSignificance != Significances[i])
+		{
+			Significances[i] = NewSignificance;
+			ApplySignificance(Character, NewSignificance);
+		}
+	}
+}
+
+void USCharacterSignificanceSubsystem::ApplySignificance(ASCharacterBase* Character, ESCharacterSignificance Significance) const
+{
+	const int32 Index = (int32)Significance;
+
+	Character->SetActorTickInterval(SignificanceActorTickIntervals[Index]);
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	if (Mesh)
+	{
+		// The server traces shots against the mesh's bones, so only clients let its pose fall behind
+		const bool bThrottlePose = !Character->HasAuthority();
+		Mesh->SetComponentTickInterval(bThrottlePose ? SignificanceMeshTickIntervals[Index] : 0.f);
+
+		// Characters nobody can see only keep their montages going, so notifies still fire
+		// The server's option is left to the lag compensation subsystem, which needs the bones refreshed
+		if (bThrottlePose)
+		{
+			const USkeletalMeshComponent* DefaultMesh = Character->GetClass()->GetDefaultObject<ASCharacterBase>()->GetMesh();
+			Mesh->VisibilityBasedAnimTickOption = Significance == ESCharacterSignificance::Lowest
+				? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered
+				: DefaultMesh->VisibilityBasedAnimTickOption;
+		}
+	}
+
+	UCharacterMovementComponent* MovementComp = Character->GetCharacterMovement();
+	if (MovementComp)
+	{
+		MovementComp->SetComponentTickInterval(SignificanceMovementTickIntervals[Index]);
+	}
+}
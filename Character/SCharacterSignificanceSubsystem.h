@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SCharacterSignificanceSubsystem.generated.h"
+
+class ASCharacterBase;
+
+/**
+* How much a character matters to the players, from most to least
+*/
+UENUM(BlueprintType)
+enum class ESCharacterSignificance : uint8
+{
+	High,
+	Medium,
+	Low,
+	Lowest
+};
+
+/**
+* Scores every ASCharacterBase by its distance to the closest player view, counting characters behind the view or not rendered as further away
+* Each character's actor, mesh and movement tick intervals are scaled by its score, characters controlled on this machine always stay High
+* Meshes are only throttled on clients, the server keeps every pose up to date for hitbox traces
+* Scores are only recalculated every COOP.SignificanceInterval seconds, and a character's tick settings only change when its score does
+*/
+UCLASS()
+class COOPHORDE_API USCharacterSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Starts scoring Character */
+	void RegisterCharacter(ASCharacterBase* Character);
+
+	/** Stops scoring Character, restoring its High tick settings */
+	void UnregisterCharacter(ASCharacterBase* Character);
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** Every registered character */
+	UPROPERTY(Transient)
+	TArray<ASCharacterBase*> Characters;
+
+	/** The significance last applied to each character, by index in Characters */
+	TArray<ESCharacterSignificance> Significances;
+
+	/** The time left until the scores are recalculated */
+	float TimeUntilUpdate;
+
+	/** Scores every character and applies any that changed */
+	void UpdateSignificance();
+
+	/** Sets the tick intervals of Character for Significance */
+	void ApplySignificance(ASCharacterBase* Character, ESCharacterSignificance Significance) const;
+};
@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCharacterStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(CharacterChannel);
+
+DEFINE_LOG_CATEGORY(LogCoopCharacters);
+
+DEFINE_STAT(STAT_CharacterAimUpdate);
+DEFINE_STAT(STAT_CharacterSignificance);
+DEFINE_STAT(STAT_CharacterRagdollUpdate);
+
+DEFINE_STAT(STAT_CharacterRagdollsOverBudget);
+
+DEFINE_STAT(STAT_CharacterPooledCharacters);
+DEFINE_STAT(STAT_CharacterSimulatingRagdolls);
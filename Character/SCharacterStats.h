@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+* Stats, trace channel and log category shared by the characters and their subsystems
+* Shown in game with "stat CoopCharacters", and captured by Unreal Insights when the Character channel is enabled, e.g. -trace=cpu,character
+*/
+DECLARE_STATS_GROUP(TEXT("CoopCharacters"), STATGROUP_CoopCharacters, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(CharacterChannel, COOPHORDE_API);
+
+/** Log category of the characters and their subsystems */
+COOPHORDE_API DECLARE_LOG_CATEGORY_EXTERN(LogCoopCharacters, Log, All);
+
+/** Counts the scope in STATGROUP_CoopCharacters and traces it as a CPU event on the CharacterChannel */
+#define SCOPE_CHARACTER_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, CharacterChannel)
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Aim Update"), STAT_CharacterAimUpdate, STATGROUP_CoopCharacters, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Significance"), STAT_CharacterSignificance, STATGROUP_CoopCharacters, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ragdoll Update"), STAT_CharacterRagdollUpdate, STATGROUP_CoopCharacters, COOPHORDE_API);
+
+// Work done per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ragdolls Over Budget"), STAT_CharacterRagdollsOverBudget, STATGROUP_CoopCharacters, COOPHORDE_API);
+
+// Live objects owned by the character systems
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Characters"), STAT_CharacterPooledCharacters, STATGROUP_CoopCharacters, COOPHORDE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Simulating Ragdolls"), STAT_CharacterSimulatingRagdolls, STATGROUP_CoopCharacters, COOPHORDE_API);
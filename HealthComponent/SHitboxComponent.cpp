@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/SHitboxComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "GameFramework/Actor.h"
+
+// Sets default values for this component's properties
+USHitboxComponent::USHitboxComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+const FSHitboxTag& USHitboxComponent::GetTagForBone(FName BoneName) const
+{
+	const int32* TagIndex = BoneTagIndices.Find(BoneName);
+	return TagIndex ? BoneTags[*TagIndex] : DefaultTag;
+}
+
+// Called when the game starts
+void USHitboxComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	BuildBoneTagIndices();
+}
+
+void USHitboxComponent::BuildBoneTagIndices()
+{
+	BoneTagIndices.Reset();
+
+	for (int32 i = 0; i < BoneTags.Num(); i++)
+	{
+		BoneTagIndices.Add(BoneTags[i].BoneName, i);
+	}
+
+	AActor* MyOwner = GetOwner();
+	USkinnedMeshComponent* MeshComp = MyOwner ? MyOwner->FindComponentByClass<USkinnedMeshComponent>() : nullptr;
+	if (MeshComp == nullptr)
+		return;
+
+	// Resolve every untagged bone to its closest tagged parent now, so a hit never has to walk the hierarchy
+	const int32 NumBones = MeshComp->GetNumBones();
+	for (int32 BoneIndex = 0; BoneIndex < NumBones; BoneIndex++)
+	{
+		const FName BoneName = MeshComp->GetBoneName(BoneIndex);
+		if (BoneTagIndices.Contains(BoneName))
+			continue;
+
+		FName ParentName = MeshComp->GetParentBone(BoneName);
+		while (ParentName != NAME_None)
+		{
+			if (const int32* ParentTagIndex = BoneTagIndices.Find(ParentName))
+			{
+				BoneTagIndices.Add(BoneName, *ParentTagIndex);
+				break;
+			}
+			ParentName = MeshComp->GetParentBone(ParentName);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SHitboxComponent.generated.h"
+
+/**
+* The surface and damage of a hitbox, a body of the owner's physics asset
+*/
+USTRUCT(BlueprintType)
+struct FSHitboxTag
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The bone of the body, bones without their own tag use the tag of their closest tagged parent */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	FName BoneName;
+
+	/** The surface used for impact effects and decals when the body is hit */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox)
+	TEnumAsByte<EPhysicalSurface> SurfaceType;
+
+	/** Damage dealt to the body is multiplied by this */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Hitbox, meta = (ClampMin = 0.f))
+	float DamageMultiplier;
+
+	FSHitboxTag()
+		: BoneName(NAME_None)
+		, SurfaceType(SurfaceType_Default)
+		, DamageMultiplier(1.f)
+	{}
+};
+
+/**
+* HitboxComponent tags the simple collision bodies of the owner with a surface and damage multiplier
+* Weapons tracing simple collision read the tag of the hit bone instead of looking up the physical material of the hit
+*/
+
+UCLASS( ClassGroup=(COOP), meta=(BlueprintSpawnableComponent) )
+class COOPHORDE_API USHitboxComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	// Sets default values for this component's properties
+	USHitboxComponent();
+
+	/** Tag used for bodies that don't have their own tag and have no tagged parent, and for owners without a skeletal mesh */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Hitbox)
+	FSHitboxTag DefaultTag;
+
+	/** Tags of individual bodies, e.g. the head */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Hitbox)
+	TArray<FSHitboxTag> BoneTags;
+
+public:
+
+	/** Returns the tag of the body of BoneName */
+	const FSHitboxTag& GetTagForBone(FName BoneName) const;
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	/** Every bone of the owner's mesh mapped to the index in BoneTags of its tag, built once in BeginPlay */
+	TMap<FName, int32> BoneTagIndices;
+
+	/** Fills BoneTagIndices, resolving bones without a tag to their closest tagged parent */
+	void BuildBoneTagIndices();
+};
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/STimedActionComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "TimerManager.h"
+
+/** Actions finish this long before their montage does, while it blends out */
+static const float ActionFinishLeadTime = 0.2f;
+
+// Sets default values for this component's properties
+USTimedActionComponent::USTimedActionComponent()
+{
+	SetIsReplicatedByDefault(true);
+
+	ActiveActionType = ESTimedActionType::None;
+}
+
+void USTimedActionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetTimerManager().ClearTimer(TimerHandle_FinishAction);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void USTimedActionComponent::StartAction(ESTimedActionType Type, UAnimMontage* Montage)
+{
+	if (!GetOwner()->HasAuthority())
+		return;
+
+	CurrentAction.Type = Type;
+	CurrentAction.Montage = Montage;
+	CurrentAction.StartTime = GetServerWorldTime();
+	CurrentAction.Duration = Montage ? FMath::Max(Montage->GetPlayLength() / Montage->RateScale - ActionFinishLeadTime, 0.f) : 0.f;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(USTimedActionComponent, CurrentAction, this);
+	GetOwner()->ForceNetUpdate();
+
+	ApplyCurrentAction();
+}
+
+void USTimedActionComponent::ResetAction()
+{
+	if (!GetOwner()->HasAuthority())
+		return;
+
+	GetWorld()->GetTimerManager().ClearTimer(TimerHandle_FinishAction);
+	ActiveActionType = ESTimedActionType::None;
+
+	CurrentAction = FSTimedAction();
+	MARK_PROPERTY_DIRTY_FROM_NAME(USTimedActionComponent, CurrentAction, this);
+}
+
+void USTimedActionComponent::OnRep_CurrentAction()
+{
+	ApplyCurrentAction();
+}
+
+void USTimedActionComponent::ApplyCurrentAction()
+{
+	// Whatever was playing has been replaced
+	GetWorld()->GetTimerManager().ClearTimer(TimerHandle_FinishAction);
+	ActiveActionType = ESTimedActionType::None;
+
+	const float ElapsedTime = FMath::Max(GetServerWorldTime() - CurrentAction.StartTime, 0.f);
+	if (CurrentAction.Type == ESTimedActionType::None || ElapsedTime > CurrentAction.Duration)
+		return;
+
+	ActiveActionType = CurrentAction.Type;
+
+	ACharacter* OwningCharacter = Cast<ACharacter>(GetOwner());
+	UAnimInstance* AnimInstance = OwningCharacter && OwningCharacter->GetMesh() ? OwningCharacter->GetMesh()->GetAnimInstance() : nullptr;
+	if (AnimInstance && CurrentAction.Montage)
+	{
+		AnimInstance->Montage_Play(CurrentAction.Montage, 1.f, EMontagePlayReturnType::MontageLength, ElapsedTime * CurrentAction.Montage->RateScale);
+	}
+
+	OnActionStarted.Broadcast(this, ActiveActionType);
+
+	GetWorld()->GetTimerManager().SetTimer(TimerHandle_FinishAction, this, &USTimedActionComponent::FinishAction, FMath::Max(CurrentAction.Duration - ElapsedTime, KINDA_SMALL_NUMBER));
+}
+
+void USTimedActionComponent::FinishAction()
+{
+	const ESTimedActionType FinishedActionType = ActiveActionType;
+	ActiveActionType = ESTimedActionType::None;
+
+	OnActionFinished.Broadcast(this, FinishedActionType);
+}
+
+float USTimedActionComponent::GetServerWorldTime() const
+{
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->TimeSeconds;
+}
+
+void USTimedActionComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(USTimedActionComponent, CurrentAction, Params);
+}
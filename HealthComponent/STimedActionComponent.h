@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "STimedActionComponent.generated.h"
+
+class UAnimMontage;
+class USTimedActionComponent;
+
+/**
+* The actions a character can be busy with for a set time
+*/
+UENUM(BlueprintType)
+enum class ESTimedActionType : uint8
+{
+	None,
+	Reload,
+	Equip,
+	Pickup
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnTimedActionSignature, USTimedActionComponent*, TimedActionComp, ESTimedActionType, ActionType);
+
+/**
+* The last action the server started, everything else about it is worked out locally
+*/
+USTRUCT()
+struct FSTimedAction
+{
+	GENERATED_BODY()
+
+public:
+
+	/** What the character is doing */
+	UPROPERTY()
+	ESTimedActionType Type;
+
+	/** The montage played for the action */
+	UPROPERTY()
+	UAnimMontage* Montage;
+
+	/** The server world time the action started at */
+	UPROPERTY()
+	float StartTime;
+
+	/** How long after StartTime the action finishes */
+	UPROPERTY()
+	float Duration;
+
+	FSTimedAction()
+		: Type(ESTimedActionType::None)
+		, Montage(nullptr)
+		, StartTime(0.f)
+		, Duration(0.f)
+	{}
+};
+
+/**
+* TimedActionComponent replicates the reload, equip or pickup the owning character is doing as a single property
+* Every machine plays the montage and finishes the action itself from the server start time, so late joiners pick up an action part way through
+* and only connections the character is relevant to receive it
+*/
+
+UCLASS( ClassGroup=(COOP), meta=(BlueprintSpawnableComponent) )
+class COOPHORDE_API USTimedActionComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	USTimedActionComponent();
+
+	/** Event that is broadcast on every machine when an action starts */
+	UPROPERTY(BlueprintAssignable, Category = Events)
+	FOnTimedActionSignature OnActionStarted;
+
+	/** Event that is broadcast on every machine when an action finishes, actions replaced by another one never finish */
+	UPROPERTY(BlueprintAssignable, Category = Events)
+	FOnTimedActionSignature OnActionFinished;
+
+public:
+
+	/** Starts Type on the server, lasting as long as Montage plays for, replacing the current action */
+	void StartAction(ESTimedActionType Type, UAnimMontage* Montage);
+
+	/** Drops the current action on the server without finishing it, for characters going back to the pool */
+	void ResetAction();
+
+	/** Returns the action that is playing on this machine */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = TimedAction)
+	FORCEINLINE ESTimedActionType GetActiveActionType() const { return ActiveActionType; }
+
+	/** Whether Type is playing on this machine */
+	FORCEINLINE bool IsActionActive(ESTimedActionType Type) const { return ActiveActionType == Type; }
+
+protected:
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** The last action started by the server */
+	UPROPERTY(ReplicatedUsing = OnRep_CurrentAction)
+	FSTimedAction CurrentAction;
+
+	/** The action playing on this machine, None once it has finished */
+	ESTimedActionType ActiveActionType;
+
+	/** Handle to the timer finishing the active action */
+	FTimerHandle TimerHandle_FinishAction;
+
+	UFUNCTION()
+	void OnRep_CurrentAction();
+
+	/** Plays CurrentAction from however far into it the server is, ignoring it if it has already finished */
+	void ApplyCurrentAction();
+
+	/** Finishes the active action */
+	void FinishAction();
+
+	/** Returns the server world time */
+	float GetServerWorldTime() const;
+};
@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SCosmeticEventSubsystem.h"
+#include "Camera/CameraShake.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "SImpactFXSubsystem.h"
+#include "SWeapon.h"
+#include "SWeaponStats.h"
+
+static float CosmeticFireCullDistance = 8000.f;
+FAutoConsoleVariableRef CVARCosmeticFireCullDistance(
+	TEXT("COOP.CosmeticFireCullDistance"),
+	CosmeticFireCullDistance,
+	TEXT("Shots and tracers of weapons further than this from the local view are not played, unless the weapon is held by a local player"),
+	ECVF_Default);
+
+static float CosmeticImpactCullDistance = 5000.f;
+FAutoConsoleVariableRef CVARCosmeticImpactCullDistance(
+	TEXT("COOP.CosmeticImpactCullDistance"),
+	CosmeticImpactCullDistance,
+	TEXT("Impacts further than this from the local view are not played"),
+	ECVF_Default);
+
+static float CosmeticRenderedTolerance = 0.2f;
+FAutoConsoleVariableRef CVARCosmeticRenderedTolerance(
+	TEXT("COOP.CosmeticRenderedTolerance"),
+	CosmeticRenderedTolerance,
+	TEXT("Weapons not rendered within this many seconds only play their fire sound"),
+	ECVF_Default);
+
+static int32 CosmeticMaxTracersPerFrame = 32;
+FAutoConsoleVariableRef CVARCosmeticMaxTracersPerFrame(
+	TEXT("COOP.CosmeticMaxTracersPerFrame"),
+	CosmeticMaxTracersPerFrame,
+	TEXT("The maximum number of tracers played per frame, the closest weapons get theirs first"),
+	ECVF_Default);
+
+/**
+* A weapon with requests this frame and how far it is from the view
+*/
+struct FSWeaponCosmeticsEntry
+{
+	ASWeapon* Weapon;
+
+	const FSQueuedWeaponCosmetics* Cosmetics;
+
+	float DistanceSquared;
+
+	bool bLocallyControlled;
+};
+
+void USCosmeticEventSubsystem::QueueFire(ASWeapon* Weapon)
+{
+	if (Weapon == nullptr || !ShouldQueueEvents())
+		return;
+
+	PendingWeapons.FindOrAdd(Weapon).NumShots++;
+}
+
+void USCosmeticEventSubsystem::QueueTracer(ASWeapon* Weapon, const FVector& TraceEnd)
+{
+	if (Weapon == nullptr || !ShouldQueueEvents())
+		return;
+
+	PendingWeapons.FindOrAdd(Weapon).TracerEnds.Add(TraceEnd);
+}
+
+void USCosmeticEventSubsystem::QueueImpact(EPhysicalSurface SurfaceType, UFXSystemAsset* Effect, USoundBase* Sound, const FVector& Location, const FRotator& Rotation)
+{
+	if ((Effect == nullptr && Sound == nullptr) || !ShouldQueueEvents())
+		return;
+
+	PendingImpacts.Add({ SurfaceType, Effect, Sound, Location, Rotation });
+}
+
+void USCosmeticEventSubsystem::QueueCameraShake(APlayerController* PlayerController, TSubclassOf<UCameraShake> Shake)
+{
+	// Shakes are only played where the player is, never sent to a remote client
+	if (PlayerController == nullptr || Shake == nullptr || !PlayerController->IsLocalController())
+		return;
+
+	PendingCameraShakes.AddUnique({ PlayerController, Shake });
+}
+
+void USCosmeticEventSubsystem::Tick(float DeltaTime)
+{
+	FlushEvents();
+}
+
+ETickableTickType USCosmeticEventSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool USCosmeticEventSubsystem::IsTickable() const
+{
+	return PendingWeapons.Num() > 0 || PendingImpacts.Num() > 0 || PendingCameraShakes.Num() > 0;
+}
+
+TStatId USCosmeticEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USCosmeticEventSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* USCosmeticEventSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void USCosmeticEventSubsystem::FlushEvents()
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponFlushCosmetics);
+
+	FVector ViewLocation;
+	const bool bHasView = GetViewLocation(ViewLocation);
+
+	// Weapons held by local players first, then the closest
+	TArray<FSWeaponCosmeticsEntry, TInlineAllocator<16>> Entries;
+	for (const TPair<TWeakObjectPtr<ASWeapon>, FSQueuedWeaponCosmetics>& Pair : PendingWeapons)
+	{
+		ASWeapon* Weapon = Pair.Key.Get();
+		if (Weapon == nullptr)
+			continue;
+
+		APawn* OwnerPawn = Cast<APawn>(Weapon->GetOwner());
+		const bool bLocallyControlled = OwnerPawn && OwnerPawn->IsLocallyControlled();
+		const float DistanceSquared = bHasView ? FVector::DistSquared(ViewLocation, Weapon->GetActorLocation()) : 0.f;
+
+		if (!bLocallyControlled && DistanceSquared > FMath::Square(CosmeticFireCullDistance))
+		{
+			INC_DWORD_STAT_BY(STAT_WeaponCosmeticsCulled, Pair.Value.NumShots + Pair.Value.TracerEnds.Num());
+			continue;
+		}
+
+		Entries.Add({ Weapon, &Pair.Value, DistanceSquared, bLocallyControlled });
+	}
+
+	Entries.Sort([](const FSWeaponCosmeticsEntry& A, const FSWeaponCosmeticsEntry& B)
+	{
+		return A.bLocallyControlled != B.bLocallyControlled ? A.bLocallyControlled : A.DistanceSquared < B.DistanceSquared;
+	});
+
+	int32 NumTracers = 0;
+	for (const FSWeaponCosmeticsEntry& Entry : Entries)
+	{
+		if (Entry.Cosmetics->NumShots > 0)
+		{
+			// Weapons out of sight can still be heard
+			const bool bPlayVisuals = Entry.bLocallyControlled || Entry.Weapon->WasRecentlyRendered(CosmeticRenderedTolerance);
+			Entry.Weapon->PlayQueuedFireEffect(Entry.Cosmetics->NumShots, bPlayVisuals);
+		}
+
+		for (const FVector& TraceEnd : Entry.Cosmetics->TracerEnds)
+		{
+			if (NumTracers >= CosmeticMaxTracersPerFrame)
+			{
+				INC_DWORD_STAT(STAT_WeaponCosmeticsCulled);
+				continue;
+			}
+
+			Entry.Weapon->PlayTracerEffects(TraceEnd);
+			NumTracers++;
+		}
+	}
+
+	USImpactFXSubsystem* FXSubsystem = GetWorld()->GetSubsystem<USImpactFXSubsystem>();
+	if (FXSubsystem && PendingImpacts.Num() > 0)
+	{
+		for (const FSQueuedImpact& Impact : PendingImpacts)
+		{
+			if (bHasView && FVector::DistSquared(ViewLocation, Impact.Location) > FMath::Square(CosmeticImpactCullDistance))
+			{
+				INC_DWORD_STAT(STAT_WeaponCosmeticsCulled);
+				continue;
+			}
+
+			FXSubsystem->QueueImpact(Impact.SurfaceType, Impact.Effect, Impact.Sound, Impact.Location, Impact.Rotation);
+		}
+
+		// Played in the same batch instead of whenever the FX subsystem ticks
+		FXSubsystem->FlushImpacts();
+	}
+
+	for (const FSQueuedCameraShake& CameraShake : PendingCameraShakes)
+	{
+		APlayerController* PlayerController = CameraShake.PlayerController.Get();
+		if (PlayerController && PlayerController->PlayerCameraManager)
+		{
+			PlayerController->PlayerCameraManager->PlayCameraShake(CameraShake.Shake);
+		}
+	}
+
+	PendingWeapons.Reset();
+	PendingImpacts.Reset();
+	PendingCameraShakes.Reset();
+}
+
+bool USCosmeticEventSubsystem::GetViewLocation(FVector& OutViewLocation) const
+{
+	APlayerController* PlayerController = UGameplayStatics::GetPlayerController(GetWorld(), 0);
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+		return false;
+
+	OutViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	return true;
+}
+
+bool USCosmeticEventSubsystem::ShouldQueueEvents() const
+{
+	return !GetWorld()->IsNetMode(NM_DedicatedServer);
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SCosmeticEventSubsystem.generated.h"
+
+class ASWeapon;
+class APlayerController;
+class UCameraShake;
+class UFXSystemAsset;
+class USoundBase;
+
+/**
+* The fire and tracer requests of a single weapon this frame
+*/
+struct FSQueuedWeaponCosmetics
+{
+	/** The number of shots fired, their muzzle flash and sound are only played once */
+	int32 NumShots;
+
+	/** The end of every tracer requested */
+	TArray<FVector, TInlineAllocator<8>> TracerEnds;
+
+	FSQueuedWeaponCosmetics()
+		: NumShots(0)
+	{}
+};
+
+/**
+* An impact requested this frame, handed to USImpactFXSubsystem if it isn't culled
+*/
+struct FSQueuedImpact
+{
+	EPhysicalSurface SurfaceType;
+
+	UFXSystemAsset* Effect;
+
+	USoundBase* Sound;
+
+	FVector Location;
+
+	FRotator Rotation;
+};
+
+/**
+* A camera shake requested for a local player this frame
+*/
+struct FSQueuedCameraShake
+{
+	TWeakObjectPtr<APlayerController> PlayerController;
+
+	TSubclassOf<UCameraShake> Shake;
+
+	bool operator==(const FSQueuedCameraShake& Other) const
+	{
+		return PlayerController == Other.PlayerController && Shake == Other.Shake;
+	}
+};
+
+/**
+* Collects the fire, tracer, impact and camera shake requests of every weapon during a frame and plays them in one batch at the end of it
+* Weapons further than the cull distances from the local view are skipped, and the muzzle flash and recoil of weapons that weren't rendered
+* Nothing is queued on dedicated servers, and camera shakes only ever play for local player controllers
+*/
+UCLASS()
+class COOPHORDE_API USCosmeticEventSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Queues the muzzle flash, fire sound and recoil of a shot from Weapon */
+	void QueueFire(ASWeapon* Weapon);
+
+	/** Queues a tracer from the muzzle of Weapon to TraceEnd */
+	void QueueTracer(ASWeapon* Weapon, const FVector& TraceEnd);
+
+	/** Queues an impact, merged with the other impacts of the frame by USImpactFXSubsystem */
+	void QueueImpact(EPhysicalSurface SurfaceType, UFXSystemAsset* Effect, USoundBase* Sound, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator);
+
+	/** Queues Shake for PlayerController if it is a local player controller, the same shake is only played once a frame */
+	void QueueCameraShake(APlayerController* PlayerController, TSubclassOf<UCameraShake> Shake);
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** The weapons with requests this frame */
+	TMap<TWeakObjectPtr<ASWeapon>, FSQueuedWeaponCosmetics> PendingWeapons;
+
+	/** Impacts requested this frame */
+	TArray<FSQueuedImpact> PendingImpacts;
+
+	/** Camera shakes requested this frame */
+	TArray<FSQueuedCameraShake> PendingCameraShakes;
+
+	/** Plays everything queued this frame that isn't culled */
+	void FlushEvents();
+
+	/** Gets the camera location of the first local player, returns false if there is none */
+	bool GetViewLocation(FVector& OutViewLocation) const;
+
+	/** Whether anything is played in this world, false on dedicated servers */
+	bool ShouldQueueEvents() const;
+};
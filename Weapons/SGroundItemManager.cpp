@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SGroundItemManager.h"
+#include "SGroundItemSubsystem.h"
+#include "SWeapon.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Net/UnrealNetwork.h"
+
+FTransform FSGroundItem::GetTransform() const
+{
+	return FTransform(FRotator(90.f, FRotator::DecompressAxisFromShort(Yaw), 0.f), Location);
+}
+
+void FSGroundItem::PostReplicatedAdd(const FSGroundItemArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->ShowItem(*this);
+	}
+}
+
+void FSGroundItem::PreReplicatedRemove(const FSGroundItemArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->HideItem(ItemId);
+	}
+}
+
+ASGroundItemManager::ASGroundItemManager()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	SetReplicates(true);
+	bAlwaysRelevant = true;
+
+	// Only woken up by FlushNetDormancy() when an item is added or removed
+	NetDormancy = DORM_DormantAll;
+	NetUpdateFrequency = 10.f;
+
+	GroundItems.Owner = this;
+	NextItemId = 0;
+}
+
+void ASGroundItemManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	USGroundItemSubsystem* GroundItemSubsystem = GetWorld()->GetSubsystem<USGroundItemSubsystem>();
+	if (GroundItemSubsystem)
+	{
+		GroundItemSubsystem->SetManager(this);
+	}
+}
+
+void ASGroundItemManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	USGroundItemSubsystem* GroundItemSubsystem = GetWorld()->GetSubsystem<USGroundItemSubsystem>();
+	if (GroundItemSubsystem && GroundItemSubsystem->GetManager() == this)
+	{
+		GroundItemSubsystem->SetManager(nullptr);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 ASGroundItemManager::AddItem(TSubclassOf<ASWeapon> WeaponClass, int32 CurrentAmmo, int32 CurrentAmmoInClip, const FVector& Location, float Yaw, float ExpireTime)
+{
+	FSGroundItem& Item = GroundItems.Items.AddDefaulted_GetRef();
+	Item.ItemId = NextItemId++;
+	Item.WeaponClass = WeaponClass;
+	Item.CurrentAmmo = CurrentAmmo;
+	Item.CurrentAmmoInClip = CurrentAmmoInClip;
+	Item.Location = Location;
+	Item.Yaw = FRotator::CompressAxisToShort(Yaw);
+	Item.ExpireTime = ExpireTime;
+
+	ItemIndices.Add(Item.ItemId, GroundItems.Items.Num() - 1);
+	GroundItems.MarkItemDirty(Item);
+	FlushNetDormancy();
+
+	// The listen server's player sees the items too
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		ShowItem(Item);
+	}
+
+	return Item.ItemId;
+}
+
+bool ASGroundItemManager::RemoveItem(int32 ItemId)
+{
+	int32 Index;
+	if (!ItemIndices.RemoveAndCopyValue(ItemId, Index))
+		return false;
+
+	GroundItems.Items.RemoveAtSwap(Index, 1, false);
+	if (GroundItems.Items.IsValidIndex(Index))
+	{
+		ItemIndices[GroundItems.Items[Index].ItemId] = Index;
+	}
+
+	GroundItems.MarkArrayDirty();
+	FlushNetDormancy();
+
+	HideItem(ItemId);
+
+	return true;
+}
+
+const FSGroundItem* ASGroundItemManager::FindItem(int32 ItemId) const
+{
+	if (HasAuthority())
+	{
+		const int32* Index = ItemIndices.Find(ItemId);
+		return Index ? &GroundItems.Items[*Index] : nullptr;
+	}
+
+	// Clients don't keep the indices, the array is changed under them by replication
+	return GroundItems.Items.FindByPredicate([ItemId](const FSGroundItem& Item) { return Item.ItemId == ItemId; });
+}
+
+void ASGroundItemManager::ShowItem(const FSGroundItem& Item)
+{
+	if (Item.WeaponClass == nullptr || ItemMeshes.Contains(Item.ItemId))
+		return;
+
+	// Look the same as the weapon, without any of its components or logic
+	USkeletalMeshComponent* WeaponMesh = Item.WeaponClass->GetDefaultObject<ASWeapon>()->GetSkeletalMeshComponent();
+	if (WeaponMesh == nullptr)
+		return;
+
+	USkeletalMeshComponent* ItemMesh = FreeItemMeshes.Num() > 0 ? FreeItemMeshes.Pop(false) : nullptr;
+	if (ItemMesh == nullptr)
+	{
+		ItemMesh = NewObject<USkeletalMeshComponent>(this);
+		ItemMesh->SetupAttachment(RootComponent);
+		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		ItemMesh->SetGenerateOverlapEvents(false);
+		ItemMesh->SetComponentTickEnabled(false);
+		ItemMesh->PrimaryComponentTick.bCanEverTick = false;
+		ItemMesh->RegisterComponent();
+	}
+
+	ItemMesh->SetSkeletalMesh(WeaponMesh->SkeletalMesh);
+	ItemMesh->EmptyOverrideMaterials();
+	for (int32 MaterialIndex = 0; MaterialIndex < WeaponMesh->OverrideMaterials.Num(); MaterialIndex++)
+	{
+		ItemMesh->SetMaterial(MaterialIndex, WeaponMesh->OverrideMaterials[MaterialIndex]);
+	}
+	ItemMesh->SetWorldTransform(Item.GetTransform());
+	ItemMesh->SetVisibility(true);
+
+	ItemMeshes.Add(Item.ItemId, ItemMesh);
+}
+
+void ASGroundItemManager::HideItem(int32 ItemId)
+{
+	USkeletalMeshComponent* ItemMesh;
+	if (ItemMeshes.RemoveAndCopyValue(ItemId, ItemMesh) && ItemMesh)
+	{
+		ItemMesh->SetVisibility(false);
+		FreeItemMeshes.Add(ItemMesh);
+	}
+}
+
+void ASGroundItemManager::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASGroundItemManager, GroundItems);
+}
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "SGroundItemManager.generated.h"
+
+class ASWeapon;
+class ASGroundItemManager;
+class USkeletalMeshComponent;
+struct FSGroundItemArray;
+
+/**
+* A dropped weapon lying on the ground, kept as a record instead of an actor until someone picks it up
+*/
+USTRUCT()
+struct FSGroundItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Unique id of the item, used to pick it up */
+	UPROPERTY()
+	int32 ItemId;
+
+	/** The weapon spawned when the item is picked up */
+	UPROPERTY()
+	TSubclassOf<ASWeapon> WeaponClass;
+
+	/** Ammo held outside the clip when the weapon was dropped */
+	UPROPERTY()
+	int32 CurrentAmmo;
+
+	/** Ammo in the clip when the weapon was dropped */
+	UPROPERTY()
+	int32 CurrentAmmoInClip;
+
+	/** Where the weapon lies */
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	/** Yaw of the weapon, compressed to a short */
+	UPROPERTY()
+	uint16 Yaw;
+
+	/** The server world time the item is removed at */
+	UPROPERTY(NotReplicated)
+	float ExpireTime;
+
+	FSGroundItem()
+		: ItemId(INDEX_NONE)
+		, CurrentAmmo(0)
+		, CurrentAmmoInClip(0)
+		, Location(FVector::ZeroVector)
+		, Yaw(0)
+		, ExpireTime(0.f)
+	{}
+
+	/** Returns the transform of the weapon lying on its side */
+	FTransform GetTransform() const;
+
+	/** Shows the weapon on clients */
+	void PostReplicatedAdd(const FSGroundItemArray& InArraySerializer);
+
+	/** Hides the weapon on clients */
+	void PreReplicatedRemove(const FSGroundItemArray& InArraySerializer);
+};
+
+/**
+* Every ground item in the world, replicated as a fast array so only added and removed items are sent
+*/
+USTRUCT()
+struct FSGroundItemArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The items on the ground, in no particular order */
+	UPROPERTY()
+	TArray<FSGroundItem> Items;
+
+	/** The manager these items belong to */
+	UPROPERTY(NotReplicated)
+	ASGroundItemManager* Owner;
+
+	FSGroundItemArray()
+		: Owner(nullptr)
+	{}
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FSGroundItem, FSGroundItemArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FSGroundItemArray> : public TStructOpsTypeTraitsBase2<FSGroundItemArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
+/**
+* Replicates the ground items of USGroundItemSubsystem to clients
+* Stays dormant and is only woken up when an item is added or removed, clients show each item as a lone mesh with no collision or tick
+*/
+UCLASS(NotPlaceable)
+class COOPHORDE_API ASGroundItemManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	ASGroundItemManager();
+
+	/** Adds an item on the server and returns its id */
+	int32 AddItem(TSubclassOf<ASWeapon> WeaponClass, int32 CurrentAmmo, int32 CurrentAmmoInClip, const FVector& Location, float Yaw, float ExpireTime);
+
+	/** Removes an item on the server, returns false if there is no item with ItemId */
+	bool RemoveItem(int32 ItemId);
+
+	/** Returns the item with ItemId, or null. The pointer is only valid until the next item is added or removed */
+	const FSGroundItem* FindItem(int32 ItemId) const;
+
+	/** Returns every item on the ground */
+	FORCEINLINE const TArray<FSGroundItem>& GetItems() const { return GroundItems.Items; }
+
+	/** Shows the mesh of Item */
+	void ShowItem(const FSGroundItem& Item);
+
+	/** Hides the mesh of the item with ItemId, keeping the component for the next item */
+	void HideItem(int32 ItemId);
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** The items on the ground */
+	UPROPERTY(Replicated)
+	FSGroundItemArray GroundItems;
+
+	/** Index in GroundItems of each item id, only kept on the server */
+	TMap<int32, int32> ItemIndices;
+
+	/** The id given to the next item added */
+	int32 NextItemId;
+
+	/** The mesh showing each item */
+	UPROPERTY(Transient)
+	TMap<int32, USkeletalMeshComponent*> ItemMeshes;
+
+	/** Hidden meshes to reuse for the next items shown */
+	UPROPERTY(Transient)
+	TArray<USkeletalMeshComponent*> FreeItemMeshes;
+};
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SGroundItemSubsystem.h"
+#include "SGroundItemManager.h"
+#include "SWeapon.h"
+#include "SCharacterPlayer.h"
+#include "SWeaponStats.h"
+#include "SWeaponPoolSubsystem.h"
+
+static float GroundItemPickupRadius = 120.f;
+FAutoConsoleVariableRef CVARGroundItemPickupRadius(
+	TEXT("COOP.GroundItemPickupRadius"),
+	GroundItemPickupRadius,
+	TEXT("How close a player has to be to a dropped weapon to pick it up"),
+	ECVF_Default);
+
+static float GroundItemQueryInterval = 0.2f;
+FAutoConsoleVariableRef CVARGroundItemQueryInterval(
+	TEXT("COOP.GroundItemQueryInterval"),
+	GroundItemQueryInterval,
+	TEXT("Seconds between checking the players against the dropped weapons"),
+	ECVF_Default);
+
+static float GroundItemLifeSpan = 120.f;
+FAutoConsoleVariableRef CVARGroundItemLifeSpan(
+	TEXT("COOP.GroundItemLifeSpan"),
+	GroundItemLifeSpan,
+	TEXT("Seconds a dropped weapon stays on the ground"),
+	ECVF_Default);
+
+static int32 GroundItemMax = 64;
+FAutoConsoleVariableRef CVARGroundItemMax(
+	TEXT("COOP.GroundItemMax"),
+	GroundItemMax,
+	TEXT("The most dropped weapons on the ground at once, the oldest is removed to make room"),
+	ECVF_Default);
+
+/** The size of a grid cell, bigger than the pickup radius so a query only looks at the neighbouring cells */
+static const float GroundItemCellSize = 500.f;
+
+int32 USGroundItemSubsystem::AddItem(TSubclassOf<ASWeapon> WeaponClass, int32 CurrentAmmo, int32 CurrentAmmoInClip, const FVector& Location, float Yaw)
+{
+	UWorld* World = GetWorld();
+	if (WeaponClass == nullptr || World->GetNetMode() == NM_Client)
+		return INDEX_NONE;
+
+	if (Manager == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Manager = World->SpawnActor<ASGroundItemManager>(SpawnParams);
+		if (Manager == nullptr)
+			return INDEX_NONE;
+	}
+
+	// Make room by removing the oldest item, ids only ever go up
+	if (Manager->GetItems().Num() >= FMath::Max(GroundItemMax, 1))
+	{
+		int32 OldestItemId = MAX_int32;
+		for (const FSGroundItem& Item : Manager->GetItems())
+		{
+			OldestItemId = FMath::Min(OldestItemId, Item.ItemId);
+		}
+		RemoveItem(OldestItemId);
+	}
+
+	const int32 ItemId = Manager->AddItem(WeaponClass, CurrentAmmo, CurrentAmmoInClip, Location, Yaw, World->TimeSeconds + GroundItemLifeSpan);
+	GridCells.FindOrAdd(GetGridCell(Location)).Add(ItemId);
+
+	INC_DWORD_STAT(STAT_WeaponGroundItems);
+
+	return ItemId;
+}
+
+bool USGroundItemSubsystem::RemoveItem(int32 ItemId)
+{
+	const FSGroundItem* Item = FindItem(ItemId);
+	if (Item == nullptr)
+		return false;
+
+	const FIntPoint Cell = GetGridCell(Item->Location);
+	if (TArray<int32>* CellItems = GridCells.Find(Cell))
+	{
+		CellItems->RemoveSingleSwap(ItemId, false);
+		if (CellItems->Num() == 0)
+		{
+			GridCells.Remove(Cell);
+		}
+	}
+
+	Manager->RemoveItem(ItemId);
+
+	DEC_DWORD_STAT(STAT_WeaponGroundItems);
+
+	return true;
+}
+
+ASWeapon* USGroundItemSubsystem::TakeItem(int32 ItemId, ASCharacterBase* NewOwner)
+{
+	const FSGroundItem* Item = FindItem(ItemId);
+	if (Item == nullptr)
+		return nullptr;
+
+	USWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<USWeaponPoolSubsystem>();
+	ASWeapon* Weapon = WeaponPool ? WeaponPool->AcquireWeapon(Item->WeaponClass, NewOwner, Item->GetTransform()) : nullptr;
+	if (Weapon)
+	{
+		Weapon->SetAmmo(Item->CurrentAmmo, Item->CurrentAmmoInClip);
+	}
+
+	RemoveItem(ItemId);
+
+	return Weapon;
+}
+
+const FSGroundItem* USGroundItemSubsystem::FindItem(int32 ItemId) const
+{
+	return Manager ? Manager->FindItem(ItemId) : nullptr;
+}
+
+const FSGroundItem* USGroundItemSubsystem::FindNearestItem(const FVector& Location, float Radius) const
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponGroundItemQuery);
+
+	const FIntPoint MinCell = GetGridCell(Location - FVector(Radius));
+	const FIntPoint MaxCell = GetGridCell(Location + FVector(Radius));
+
+	const FSGroundItem* NearestItem = nullptr;
+	float NearestDistSquared = FMath::Square(Radius);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<int32>* CellItems = GridCells.Find(FIntPoint(X, Y));
+			if (CellItems == nullptr)
+				continue;
+
+			for (const int32 ItemId : *CellItems)
+			{
+				const FSGroundItem* Item = FindItem(ItemId);
+				if (Item == nullptr)
+					continue;
+
+				const float DistSquared = FVector::DistSquared(Item->Location, Location);
+				if (DistSquared <= NearestDistSquared)
+				{
+					NearestItem = Item;
+					NearestDistSquared = DistSquared;
+				}
+			}
+		}
+	}
+
+	return NearestItem;
+}
+
+void USGroundItemSubsystem::SetManager(ASGroundItemManager* NewManager)
+{
+	Manager = NewManager;
+
+	if (Manager == nullptr)
+	{
+		GridCells.Reset();
+		SET_DWORD_STAT(STAT_WeaponGroundItems, 0);
+	}
+}
+
+void USGroundItemSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilNextQuery -= DeltaTime;
+	if (TimeUntilNextQuery > 0.f)
+		return;
+
+	TimeUntilNextQuery = GroundItemQueryInterval;
+
+	RemoveExpiredItems();
+	UpdatePlayerPickups();
+}
+
+ETickableTickType USGroundItemSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool USGroundItemSubsystem::IsTickable() const
+{
+	// Pickups are decided by the server, and only while there is something to pick up
+	UWorld* World = GetWorld();
+	return World && World->GetNetMode() != NM_Client && Manager && Manager->GetItems().Num() > 0;
+}
+
+TStatId USGroundItemSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USGroundItemSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* USGroundItemSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+FIntPoint USGroundItemSubsystem::GetGridCell(const FVector& Location)
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / GroundItemCellSize), FMath::FloorToInt(Location.Y / GroundItemCellSize));
+}
+
+void USGroundItemSubsystem::RemoveExpiredItems()
+{
+	const float Now = GetWorld()->TimeSeconds;
+
+	TArray<int32, TInlineAllocator<8>> ExpiredItemIds;
+	for (const FSGroundItem& Item : Manager->GetItems())
+	{
+		if (Item.ExpireTime <= Now)
+		{
+			ExpiredItemIds.Add(Item.ItemId);
+		}
+	}
+
+	for (const int32 ItemId : ExpiredItemIds)
+	{
+		RemoveItem(ItemId);
+	}
+}
+
+void USGroundItemSubsystem::UpdatePlayerPickups()
+{
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		ASCharacterPlayer* Player = Cast<ASCharacterPlayer>((*It)->GetPawn());
+		if (Player == nullptr)
+			continue;
+
+		Player->SetOverlappingGroundItem(FindNearestItem(Player->GetActorLocation(), GroundItemPickupRadius));
+	}
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SGroundItemSubsystem.generated.h"
+
+class ASWeapon;
+class ASCharacterBase;
+class ASGroundItemManager;
+struct FSGroundItem;
+
+/**
+* Keeps dropped weapons as plain records instead of actors, replicated to clients through a dormant ASGroundItemManager
+* The records are bucketed in a 2D grid, and a few times a second each player is checked against the items in the cells around them instead of using overlaps
+* A real ASWeapon is only spawned again when an item is picked up
+*/
+UCLASS()
+class COOPHORDE_API USGroundItemSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Puts a weapon of WeaponClass on the ground on the server, returns the id of the new item */
+	int32 AddItem(TSubclassOf<ASWeapon> WeaponClass, int32 CurrentAmmo, int32 CurrentAmmoInClip, const FVector& Location, float Yaw);
+
+	/** Removes an item on the server, returns false if there is no item with ItemId */
+	bool RemoveItem(int32 ItemId);
+
+	/** Takes the weapon of an item from the weapon pool for NewOwner with the item's ammo and removes the item, returns null if there is no item with ItemId */
+	ASWeapon* TakeItem(int32 ItemId, ASCharacterBase* NewOwner);
+
+	/** Returns the item with ItemId, or null. The pointer is only valid until the next item is added or removed */
+	const FSGroundItem* FindItem(int32 ItemId) const;
+
+	/** Returns the closest item within Radius of Location on the server, or null */
+	const FSGroundItem* FindNearestItem(const FVector& Location, float Radius) const;
+
+	/** Sets the actor replicating the items, called by the manager as it begins and ends play */
+	void SetManager(ASGroundItemManager* NewManager);
+
+	FORCEINLINE ASGroundItemManager* GetManager() const { return Manager; }
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** The actor replicating the items, spawned by the server with the first item */
+	UPROPERTY(Transient)
+	ASGroundItemManager* Manager;
+
+	/** The ids of the items in each grid cell */
+	TMap<FIntPoint, TArray<int32>> GridCells;
+
+	/** Time left until the players are next checked against the items */
+	float TimeUntilNextQuery;
+
+	/** Returns the grid cell containing Location */
+	static FIntPoint GetGridCell(const FVector& Location);
+
+	/** Removes every item past its ExpireTime */
+	void RemoveExpiredItems();
+
+	/** Finds the closest item to each player, picking up ammo for weapons they already carry */
+	void UpdatePlayerPickups();
+};
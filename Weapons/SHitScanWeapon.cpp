@@ -1,297 +1,1079 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "SHitScanWeapon.h"
-#include "SCharacterBase.h"
-#include "DrawDebugHelpers.h"
-#include "Kismet/GameplayStatics.h"
-#include "Net/UnrealNetwork.h"
-#include "PhysicalMaterials/PhysicalMaterial.h"
-#include "Particles/ParticleSystemComponent.h"
-#include "TimerManager.h"
-#include "NiagaraFunctionLibrary.h"
-#include "NiagaraSystem.h"
-#include "NiagaraComponent.h"
-#include "Components/DecalComponent.h"
-#include "../CoopHorde.h"
-
-ASHitScanWeapon::ASHitScanWeapon()
-{
-	TracerTargetName = "TraceEnd";
-	MaxShotDistance = 100000;
-
-	BulletSpread = 3.f;
-	BulletSpreadADS = 1.f;
-
-	TimeBetweenAccurateShots = 0.5f;
-	ShotsFiredThisSpread = 0.f;
-
-	bHasFirstShotAccuracy = true;
-	bDecreaseAccuracyPerShot = true;
-	BulletsPerFire = 1;
-
-	CurrentBulletSpread = 0.f;
-}
-
-void ASHitScanWeapon::BeginPlay()
-{
-	Super::BeginPlay();
-}
-
-void ASHitScanWeapon::Fire()
-{
-	// Trace the world, from pawn eyes to crosshair location
-
-	if (!HasAuthority()) // If client, call server
-	{
-		ServerFire();
-	}
-
-	AActor* MyOwner = GetOwner();
-
-	if (MyOwner)
-	{
-		FVector EyeLocation;
-		FRotator EyeRotation;
-
-		MyOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
-		
-		FVector MuzzleLocation = Mesh->GetSocketLocation(MuzzleSocketName);
-
-		FVector ShotDirection = EyeRotation.Vector();
-
-		for (int32 i = 0; i < BulletsPerFire; i++)
-		{
-			FireBullet(ShotDirection, EyeLocation, MuzzleLocation);
-		}
-
-		PlayFireEffect();
-
-		LastFireTime = GetWorld()->TimeSeconds;
-
-		// Broadcast OnWeaponFired Event
-		OnWeaponFired.Broadcast();
-	}
-}
-
-void ASHitScanWeapon::FireBullet(FVector ShotDirection, FVector EyeLocation, FVector MuzzleLocation)
-{
-	// Handle bullet spread
-	ShotDirection = AddBulletSpread(ShotDirection);
-
-	// End of trace if nothing is hit
-	FVector TraceEnd = EyeLocation + (ShotDirection * MaxShotDistance);
-	FVector TracerEndPoint = TraceEnd;
-
-	EPhysicalSurface SurfaceType = SurfaceType_Default;
-
-	// Do line trace from camera to find closest object that can be hit
-	FHitResult ClosestObject = LineTraceShot(GetOwner(), EyeLocation, TraceEnd);
-	if (ClosestObject.bBlockingHit)
-	{
-		TraceEnd = ClosestObject.ImpactPoint;
-	}
-
-	// Actually bullet line trace from weapon to closest object that can be hit
-	FVector NewEnd = TraceEnd + (ShotDirection * 10);
-	FHitResult HitResult = LineTraceShot(GetOwner(), MuzzleLocation, NewEnd);
-	if (HitResult.bBlockingHit)
-	{
-		SurfaceType = UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
-
-		float ActualDamage = CurrentDamage;
-		if (SurfaceType == SURFACE_FLESHVULNERABLE) // Multiply damage if hit a vulnerable spot
-		{
-			ActualDamage *= 2.f;
-		}
-
-		AActor* HitActor = HitResult.GetActor();
-		// Apply damage to hit
-		UGameplayStatics::ApplyPointDamage(HitActor, ActualDamage, ShotDirection, HitResult, GetOwner()->GetInstigatorController(), GetOwner(), DamageType);
-
-		SpawnImpactDecal(HitResult);
-
-		ClosestObject = HitResult;
-		TraceEnd = HitResult.ImpactPoint;
-	}
-
-	PlayTracerEffects(TraceEnd);
-	PlayImpactEffects(SurfaceType, ClosestObject.ImpactPoint);
-
-	// Server replicates effects to clients using HitScanTrace and OnRep_HitScanTrace()
-	if (HasAuthority())
-	{
-		HitScanTrace.TraceEnd = TraceEnd;
-		HitScanTrace.SurfaceType = SurfaceType;
-		HitScanTrace.ReplicationCount++; // Increment to force replication incase the other values don't change
-	}
-}
-
-void ASHitScanWeapon::PlayImpactEffects(EPhysicalSurface SurfaceType, FVector ImpactPoint)
-{
-	if (SurfaceType == SURFACE_METALDEFAULT || SurfaceType == SURFACE_METALVULNERABLE)
-	{
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, MetalImpactEffect, ImpactPoint);
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), ImpactSoundMetal, ImpactPoint);
-		return;
-	}
-
-	UParticleSystem* SelectedParticleEffect;
-	USoundBase* SelectedSoundEffect;
-	switch (SurfaceType)
-	{
-	case SURFACE_FLESHDEFAULT:
-		SelectedParticleEffect = FleshImpactEffect;
-		SelectedSoundEffect = ImpactSoundFlesh;
-		break;
-	case SURFACE_FLESHVULNERABLE:
-		SelectedParticleEffect = FleshImpactEffect;
-		SelectedSoundEffect = ImpactSoundFlesh;
-		break;
-	default:
-		SelectedParticleEffect = DefaultImpactEffect;
-		SelectedSoundEffect = ImpactSoundDefault;
-		break;
-	}
-
-	if (SelectedParticleEffect)
-	{
-		FVector MuzzleLocation = GetMesh()->GetSocketLocation(MuzzleSocketName);
-		FVector ShotDirection = ImpactPoint - MuzzleLocation;
-		ShotDirection.Normalize();
-
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), SelectedParticleEffect, ImpactPoint, ShotDirection.Rotation());
-	}
-
-	if (SelectedSoundEffect)
-	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), SelectedSoundEffect, ImpactPoint);
-	}
-}
-
-void ASHitScanWeapon::PlayTracerEffects(FVector TraceEnd)
-{
-	if (TracerEffect)
-	{		
-		UNiagaraComponent* TracerComp = UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, TracerEffect, Mesh->GetSocketLocation(MuzzleSocketName));
-		
-		if (TracerComp)
-		{
-			TracerComp->SetVectorParameter(TracerTargetName, TraceEnd);
-		}
-	}
-}
-
-void ASHitScanWeapon::OnRep_HitScanTrace()
-{
-	// Play cosmetic effects
-	PlayFireEffect();
-	PlayTracerEffects(HitScanTrace.TraceEnd);
-
-	PlayImpactEffects(HitScanTrace.SurfaceType, HitScanTrace.TraceEnd);
-}
-
-FVector ASHitScanWeapon::AddBulletSpread(FVector ShotDirection)
-{
-	ShotsFiredThisSpread++;
-
-	// Restart the first shot accuracy timer
-	GetWorldTimerManager().ClearTimer(TimerHandle_FirstShotAccuracy);
-	GetWorldTimerManager().SetTimer(TimerHandle_FirstShotAccuracy, this, &ASHitScanWeapon::ResetFirstShotAccuracy, TimeBetweenAccurateShots);
-
-	if (ShotsFiredThisSpread > 1 || !OwningPawn->IsAimingDownSights() || !bHasFirstShotAccuracy)
-	{
-		if (bDecreaseAccuracyPerShot)
-		{
-			if (OwningPawn->IsAimingDownSights())
-			{
-				if (CurrentBulletSpread < BulletSpreadADS)
-				{
-					CurrentBulletSpread += 0.1;
-				}
-
-				if (CurrentBulletSpread > BulletSpreadADS)
-				{
-					CurrentBulletSpread = BulletSpreadADS;
-				}
-			}
-			else
-			{
-				if (CurrentBulletSpread < BulletSpread)
-				{
-					CurrentBulletSpread += 0.1;
-				}
-
-				if (CurrentBulletSpread > BulletSpread)
-				{
-					CurrentBulletSpread = BulletSpread;
-				}
-			}
-		}
-		else
-		{
-			if (OwningPawn->IsAimingDownSights())
-			{
-				CurrentBulletSpread = BulletSpreadADS;
-			}
-			else
-			{
-				CurrentBulletSpread = BulletSpread;
-			}
-		}
-
-		UE_LOG(LogTemp, Warning, TEXT("Spead: %f"), CurrentBulletSpread);
-
-		float HalfRad = FMath::DegreesToRadians(CurrentBulletSpread);
-		return FMath::VRandCone(ShotDirection, HalfRad, HalfRad);
-	}
-
-	return ShotDirection;
-}
-
-FHitResult ASHitScanWeapon::LineTraceShot(AActor* MyOwner, FVector& StartLocation, FVector& EndLocation)
-{
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(MyOwner);
-	QueryParams.AddIgnoredActor(this);
-	QueryParams.bTraceComplex = true;
-	QueryParams.bReturnPhysicalMaterial = true;
-
-	FHitResult HitResult;
-	GetWorld()->LineTraceSingleByChannel(HitResult, StartLocation, EndLocation, COLLISION_WEAPON, QueryParams);
-
-	return HitResult;
-}
-
-
-void ASHitScanWeapon::ResetFirstShotAccuracy()
-{
-	ShotsFiredThisSpread = 0;
-	ResetWeaponFireSpread();
-}
-
-bool ASHitScanWeapon::SurfaceTypeIsVunerable(EPhysicalSurface PhysicalSurface)
-{
-	return PhysicalSurface == SURFACE_FLESHVULNERABLE 
-		|| PhysicalSurface == SURFACE_METALVULNERABLE;
-}
-
-void ASHitScanWeapon::SpawnImpactDecal(FHitResult HitResult)
-{
-	if (BulletHitDecal)
-	{
-		UDecalComponent* Decal = UGameplayStatics::SpawnDecalAttached(BulletHitDecal, FVector(2.5f), HitResult.Component.Get(), HitResult.BoneName, HitResult.ImpactPoint, HitResult.ImpactNormal.Rotation(), EAttachLocation::KeepWorldPosition);
-		if (Decal)
-		{
-			Decal->SetFadeScreenSize(0.002f);
-			Decal->SetFadeOut(2.f, 2.f, false);
-		}
-	}
-}
-
-void ASHitScanWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
-{
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-
-	DOREPLIFETIME_CONDITION(ASHitScanWeapon, HitScanTrace, COND_SkipOwner);
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SHitScanWeapon.h"
+#include "SCharacterBase.h"
+#include "DrawDebugHelpers.h"
+#include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "TimerManager.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "NiagaraComponent.h"
+#include "SCosmeticEventSubsystem.h"
+#include "SImpactDecalSubsystem.h"
+#include "SLagCompensationSubsystem.h"
+#include "SWeaponStats.h"
+#include "SWeaponDefinition.h"
+#include "Curves/CurveFloat.h"
+#include "Components/SHitboxComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "../CoopHorde.h"
+
+/** Shot events older than this in seconds are not replayed by clients */
+static const float MaxShotEventAge = 1.f;
+
+/** The size in cm of one step of FHitScanPelletCorrection::Distance */
+static const float CorrectionDistanceScale = 2.f;
+
+/** The size in degrees of one step of FHitScanShotEvent::Spread */
+static const float ShotSpreadScale = 0.05f;
+
+/** The number of samples baked from the spread and recoil curves */
+static const int32 SpreadCurveSamples = 64;
+
+/** The number of samples baked from the recovery curve */
+static const int32 SpreadRecoverySamples = 32;
+
+/** The async batch of COOP.BenchmarkHitScanCollision, kept alive until its last trace is delivered */
+struct FHitScanAsyncBenchmark
+{
+	FTraceDelegate TraceDelegate;
+
+	int32 OutstandingTraces;
+
+	int32 NumTraces;
+
+	int32 NumHits;
+
+	/** When the batch was issued */
+	double StartTime;
+
+	/** Game thread time spent issuing the batch */
+	double IssueSeconds;
+};
+
+static TUniquePtr<FHitScanAsyncBenchmark> HitScanAsyncBenchmark;
+
+static FAutoConsoleCommandWithWorldAndArgs CmdBenchmarkHitScanCollision(
+	TEXT("COOP.BenchmarkHitScanCollision"),
+	TEXT("Times the same shot traces from the local player's view against complex collision, against simple hitboxes, and against simple hitboxes as one async batch. Usage: COOP.BenchmarkHitScanCollision [NumTraces]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+		if (PC == nullptr)
+			return;
+
+		const int32 NumTraces = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		for (const EHitScanCollisionMode Mode : { EHitScanCollisionMode::EHCM_Complex, EHitScanCollisionMode::EHCM_SimpleHitboxes })
+		{
+			const bool bComplex = Mode == EHitScanCollisionMode::EHCM_Complex;
+
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitScanBenchmark), bComplex);
+			QueryParams.AddIgnoredActor(PC->GetPawn());
+			QueryParams.bReturnPhysicalMaterial = bComplex;
+
+			// Same seed for both modes so they trace exactly the same rays
+			FRandomStream Stream(NumTraces);
+			int32 NumHits = 0;
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < NumTraces; i++)
+			{
+				const FVector Direction = Stream.VRandCone(ViewRotation.Vector(), FMath::DegreesToRadians(5.f));
+
+				FHitResult HitResult;
+				if (World->LineTraceSingleByChannel(HitResult, ViewLocation, ViewLocation + Direction * 100000.f, COLLISION_WEAPON, QueryParams))
+				{
+					NumHits++;
+				}
+			}
+			const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+			UE_LOG(LogCoopWeapons, Log, TEXT("HitScan %s collision: %d traces, %d hits, %.3f ms, %.2f us per trace"), bComplex ? TEXT("complex") : TEXT("simple hitbox"), NumTraces, NumHits, ElapsedSeconds * 1000.0, ElapsedSeconds * 1000000.0 / NumTraces);
+		}
+
+		// The same rays issued the way bUseAsyncPelletTraces does, the game thread only pays for issuing them
+		if (HitScanAsyncBenchmark.IsValid() && HitScanAsyncBenchmark->OutstandingTraces > 0)
+		{
+			UE_LOG(LogCoopWeapons, Log, TEXT("HitScan async batch: previous batch still has %d traces in flight"), HitScanAsyncBenchmark->OutstandingTraces);
+			return;
+		}
+
+		HitScanAsyncBenchmark = MakeUnique<FHitScanAsyncBenchmark>();
+		FHitScanAsyncBenchmark& Benchmark = *HitScanAsyncBenchmark;
+		Benchmark.OutstandingTraces = NumTraces;
+		Benchmark.NumTraces = NumTraces;
+		Benchmark.NumHits = 0;
+		Benchmark.TraceDelegate.BindLambda([&Benchmark](const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+		{
+			if (TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit)
+			{
+				Benchmark.NumHits++;
+			}
+
+			if (--Benchmark.OutstandingTraces == 0)
+			{
+				const double ElapsedSeconds = FPlatformTime::Seconds() - Benchmark.StartTime;
+				UE_LOG(LogCoopWeapons, Log, TEXT("HitScan async batch: %d traces, %d hits, %.3f ms on the game thread, %.2f us per trace, results after %.3f ms"),
+					Benchmark.NumTraces, Benchmark.NumHits, Benchmark.IssueSeconds * 1000.0, Benchmark.IssueSeconds * 1000000.0 / Benchmark.NumTraces, ElapsedSeconds * 1000.0);
+			}
+		});
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitScanBenchmark), false);
+		QueryParams.AddIgnoredActor(PC->GetPawn());
+
+		FRandomStream Stream(NumTraces);
+
+		Benchmark.StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumTraces; i++)
+		{
+			const FVector Direction = Stream.VRandCone(ViewRotation.Vector(), FMath::DegreesToRadians(5.f));
+			World->AsyncLineTraceByChannel(EAsyncTraceType::Single, ViewLocation, ViewLocation + Direction * 100000.f, COLLISION_WEAPON, QueryParams, FCollisionResponseParams::DefaultResponseParam, &Benchmark.TraceDelegate);
+		}
+		Benchmark.IssueSeconds = FPlatformTime::Seconds() - Benchmark.StartTime;
+	}));
+
+void FHitScanCurveLookup::Bake(const UCurveFloat* Curve, float InMaxInput, int32 NumSamples, TFunctionRef<float(float)> Fallback)
+{
+	MaxInput = FMath::Max(InMaxInput, KINDA_SMALL_NUMBER);
+
+	Samples.SetNumUninitialized(FMath::Max(NumSamples, 2));
+	for (int32 i = 0; i < Samples.Num(); i++)
+	{
+		const float Input = MaxInput * i / (Samples.Num() - 1);
+		Samples[i] = Curve ? Curve->GetFloatValue(Input) : Fallback(Input);
+	}
+}
+
+float FHitScanCurveLookup::Evaluate(float Input) const
+{
+	if (Samples.Num() == 0)
+		return 0.f;
+
+	const float Position = FMath::Clamp(Input / MaxInput, 0.f, 1.f) * (Samples.Num() - 1);
+	const int32 Index = FMath::Min(FMath::FloorToInt(Position), Samples.Num() - 2);
+
+	return FMath::Lerp(Samples[Index], Samples[Index + 1], Position - Index);
+}
+
+FHitScanPelletCorrection::FHitScanPelletCorrection(int32 InPelletIndex, const FVector& MuzzleLocation, const FVector& ImpactPoint, EPhysicalSurface InSurfaceType)
+	: PelletIndex((uint8)InPelletIndex)
+	, SurfaceType(InSurfaceType)
+{
+	const FVector ToImpact = ImpactPoint - MuzzleLocation;
+	const FRotator Direction = ToImpact.Rotation();
+
+	DirectionYaw = FRotator::CompressAxisToShort(Direction.Yaw);
+	DirectionPitch = FRotator::CompressAxisToShort(Direction.Pitch);
+	Distance = (uint16)FMath::Clamp(FMath::RoundToInt(ToImpact.Size() / CorrectionDistanceScale), 0, (int32)MAX_uint16);
+}
+
+FVector FHitScanPelletCorrection::GetImpactPoint(const FVector& MuzzleLocation) const
+{
+	const FRotator Direction(FRotator::DecompressAxisFromShort(DirectionPitch), FRotator::DecompressAxisFromShort(DirectionYaw), 0.f);
+
+	return MuzzleLocation + Direction.Vector() * (Distance * CorrectionDistanceScale);
+}
+
+bool FHitScanPelletCorrection::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedSurfaceType = SurfaceType;
+	Ar.SerializeInt(PackedSurfaceType, SurfaceType_Max);
+
+	Ar << PelletIndex;
+	Ar << DirectionYaw;
+	Ar << DirectionPitch;
+	Ar << Distance;
+
+	if (Ar.IsLoading())
+	{
+		SurfaceType = (uint8)PackedSurfaceType;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+FHitScanShotEvent::FHitScanShotEvent(uint16 InShotSequence, float ServerWorldTime, const FRotator& AimRotation, float InSpread, uint8 InFlags)
+	: ShotSequence(InShotSequence)
+	, FireTime((uint16)(FMath::FloorToInt(ServerWorldTime * 100.f) & 0xFFFF))
+	, AimYaw(FRotator::CompressAxisToShort(AimRotation.Yaw))
+	, AimPitch(FRotator::CompressAxisToShort(AimRotation.Pitch))
+	, Spread((uint8)FMath::Clamp(FMath::RoundToInt(InSpread / ShotSpreadScale), 0, (int32)MAX_uint8))
+	, Flags(InFlags)
+{
+}
+
+FRotator FHitScanShotEvent::GetAimRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(AimPitch), FRotator::DecompressAxisFromShort(AimYaw), 0.f);
+}
+
+float FHitScanShotEvent::GetSpread() const
+{
+	return Spread * ShotSpreadScale;
+}
+
+float FHitScanShotEvent::GetAge(float ServerWorldTime) const
+{
+	const uint16 Now = (uint16)(FMath::FloorToInt(ServerWorldTime * 100.f) & 0xFFFF);
+	return (uint16)(Now - FireTime) / 100.f;
+}
+
+bool FHitScanShotEvent::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedFlags = Flags;
+	Ar.SerializeInt(PackedFlags, 2);
+
+	Ar << ShotSequence;
+	Ar << FireTime;
+	Ar << AimYaw;
+	Ar << AimPitch;
+	Ar << Spread;
+
+	uint32 NumCorrections = Corrections.Num();
+	Ar.SerializeIntPacked(NumCorrections);
+
+	if (Ar.IsLoading())
+	{
+		Flags = (uint8)PackedFlags;
+
+		// A shot can't have more corrections than pellets
+		if (NumCorrections > MAX_uint8 + 1)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+		Corrections.SetNum(NumCorrections);
+	}
+
+	for (FHitScanPelletCorrection& Correction : Corrections)
+	{
+		Correction.NetSerialize(Ar, Map, bOutSuccess);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+void FHitScanShotEvent::PostReplicatedAdd(const FHitScanShotEventArray& InArraySerializer)
+{
+	// Events received with the initial replication of the weapon are old shots, don't replay them
+	if (InArraySerializer.Owner && InArraySerializer.Owner->HasActorBegunPlay())
+	{
+		InArraySerializer.Owner->PlayShotEvent(*this);
+	}
+}
+
+void FHitScanShotEvent::PostReplicatedChange(const FHitScanShotEventArray& InArraySerializer)
+{
+	PostReplicatedAdd(InArraySerializer);
+}
+
+void FHitScanShotEventArray::AddEvent(const FHitScanShotEvent& Event)
+{
+	if (Events.Num() < Capacity)
+	{
+		MarkItemDirty(Events.Add_GetRef(Event));
+		return;
+	}
+
+	Events[NextEventIndex] = Event;
+	MarkItemDirty(Events[NextEventIndex]);
+	NextEventIndex = (NextEventIndex + 1) % Capacity;
+}
+
+void FHitScanShotEventArray::Reset()
+{
+	Events.Reset();
+	NextEventIndex = 0;
+	MarkArrayDirty();
+}
+
+ASHitScanWeapon::ASHitScanWeapon()
+{
+	TracerTargetName = "TraceEnd";
+	MaxShotDistance = 100000;
+
+	BulletSpread = 3.f;
+	BulletSpreadADS = 1.f;
+
+	TimeBetweenAccurateShots = 0.5f;
+	SpreadHeat = 0.f;
+	LastSpreadTime = 0.f;
+
+	RecoilScaleADS = 0.5f;
+	MaxSpreadHeat = 32.f;
+	SpreadHeatLimit = MaxSpreadHeat;
+	BulletSpreadPerShot = 0.1f;
+
+	bHasFirstShotAccuracy = true;
+	bDecreaseAccuracyPerShot = true;
+	BulletsPerFire = 1;
+
+	SpreadSeedSalt = 0;
+
+	TraceMode = EHitScanTraceMode::EHTM_CameraAndMuzzle;
+	MuzzleProbeDistance = 150.f;
+
+	CollisionMode = EHitScanCollisionMode::EHCM_Complex;
+	WorldHitRefineDistance = 20.f;
+
+	bUseAsyncPelletTraces = true;
+	LastPelletBatchId = 0;
+
+	ShotEvents.Owner = this;
+
+	TracerPoolSize = 4;
+	NextTracerIndex = 0;
+}
+
+void ASHitScanWeapon::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// String hashes are stable across machines unlike FName hashes
+	SpreadSeedSalt = GetTypeHash(GetClass()->GetName());
+
+	BakeSpreadCurves();
+}
+
+void ASHitScanWeapon::BakeSpreadCurves()
+{
+	// Without curves the spread grows in even steps to its maximum, or starts at the maximum
+	auto LinearSpread = [this](float MaxSpread)
+	{
+		return [this, MaxSpread](float Heat) { return bDecreaseAccuracyPerShot ? FMath::Min(Heat * BulletSpreadPerShot, MaxSpread) : MaxSpread; };
+	};
+
+	// The linear spread only stops growing once it reaches its maximum, which can take more heat than MaxSpreadHeat
+	auto SpreadHeatRange = [this](const UCurveFloat* Curve, float MaxSpread)
+	{
+		return Curve == nullptr && bDecreaseAccuracyPerShot && BulletSpreadPerShot > 0.f ? FMath::Max(MaxSpread / BulletSpreadPerShot, MaxSpreadHeat) : MaxSpreadHeat;
+	};
+
+	const float SpreadHeatRangeHip = SpreadHeatRange(SpreadCurve, BulletSpread);
+	const float SpreadHeatRangeADS = SpreadHeatRange(SpreadCurveADS, BulletSpreadADS);
+	SpreadHeatLimit = FMath::Max(SpreadHeatRangeHip, SpreadHeatRangeADS);
+
+	SpreadLookup.Bake(SpreadCurve, SpreadHeatRangeHip, SpreadCurveSamples, LinearSpread(BulletSpread));
+	SpreadLookupADS.Bake(SpreadCurveADS, SpreadHeatRangeADS, SpreadCurveSamples, LinearSpread(BulletSpreadADS));
+	SpreadRecoveryLookup.Bake(SpreadRecoveryCurve, 1.f, SpreadRecoverySamples, [](float TimeFraction) { return TimeFraction < 1.f ? 1.f : 0.f; });
+	RecoilLookup.Bake(RecoilCurve, MaxSpreadHeat, SpreadCurveSamples, [](float Heat) { return 0.f; });
+}
+
+void ASHitScanWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Tracers aren't owned by the weapon, so they have to be cleaned up with it
+	for (UNiagaraComponent* TracerComp : TracerComponents)
+	{
+		if (TracerComp)
+		{
+			TracerComp->DestroyComponent();
+		}
+	}
+	DEC_DWORD_STAT_BY(STAT_WeaponLiveTracerComponents, TracerComponents.Num());
+	TracerComponents.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASHitScanWeapon::Fire(const FSWeaponShot& Shot)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponFire);
+
+	// Trace the world, from pawn eyes to crosshair location
+
+	const uint16 ThisShotSequence = ShotSequence++;
+	const float RewindTime = ShotRewindTime;
+
+	// Scheduled shots can be fired at a time earlier in the frame, a client's shot keeps the time the client fired it at
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ShotTimeOffset = Shot.Time - GetWorld()->TimeSeconds;
+	const float ServerWorldTime = Shot.ClientFireTime >= 0.f ? Shot.ClientFireTime : (GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->TimeSeconds) + ShotTimeOffset;
+
+	if (!HasAuthority()) // If client, send the shot to the server
+	{
+		QueueFireInput(ThisShotSequence, ServerWorldTime, Shot.EyeLocation, Shot.EyeRotation);
+	}
+
+	AActor* MyOwner = GetOwner();
+
+	if (MyOwner)
+	{
+		const FVector EyeLocation = Shot.EyeLocation;
+		const FRotator EyeRotation = Shot.EyeRotation;
+		
+		FVector MuzzleLocation = Mesh->GetSocketLocation(MuzzleSocketName);
+
+		// Handle bullet spread
+		bool bFirstPelletAccurate;
+		const float Spread = UpdateBulletSpread(ServerWorldTime, bFirstPelletAccurate);
+
+		// Aim and spread are quantized the same way they are replicated so clients rebuild exactly the same pellets
+		FHitScanShotEvent ShotEvent(ThisShotSequence, ServerWorldTime, EyeRotation, Spread, bFirstPelletAccurate ? FHitScanShotEvent::FLAG_FirstPelletAccurate : 0);
+
+		// Build every pellet up front so the whole trigger pull is traced and resolved as one batch
+		TArray<FHitScanPellet> Pellets;
+		BuildPellets(ThisShotSequence, ShotEvent.GetAimRotation(), ShotEvent.GetSpread(), bFirstPelletAccurate, Pellets);
+
+		if (bUseAsyncPelletTraces)
+		{
+			TracePelletsAsync(EyeLocation, MuzzleLocation, Pellets, ShotEvent, RewindTime);
+		}
+		else
+		{
+			TracePellets(EyeLocation, MuzzleLocation, Pellets, RewindTime);
+			ResolvePellets(MuzzleLocation, Pellets, ShotEvent);
+		}
+
+		PlayFireEffect();
+		ApplyRecoil();
+
+		LastFireTime = Shot.Time;
+
+		// Broadcast OnWeaponFired Event
+		OnWeaponFired.Broadcast();
+	}
+}
+
+void ASHitScanWeapon::BuildPellets(uint16 InShotSequence, const FRotator& AimRotation, float Spread, bool bFirstPelletAccurate, TArray<FHitScanPellet>& OutPellets) const
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponBuildPellets);
+	INC_DWORD_STAT_BY(STAT_WeaponPellets, BulletsPerFire);
+
+	FRandomStream SpreadStream(GetSpreadSeed(InShotSequence));
+
+	const FVector ShotDirection = AimRotation.Vector();
+	const float HalfRad = FMath::DegreesToRadians(Spread);
+
+	OutPellets.Reserve(BulletsPerFire);
+	for (int32 i = 0; i < BulletsPerFire; i++)
+	{
+		if (i == 0 && bFirstPelletAccurate)
+		{
+			OutPellets.Emplace(ShotDirection);
+		}
+		else
+		{
+			OutPellets.Emplace(SpreadStream.VRandCone(ShotDirection, HalfRad, HalfRad));
+		}
+	}
+}
+
+int32 ASHitScanWeapon::GetSpreadSeed(uint16 InShotSequence) const
+{
+	return (int32)HashCombine(SpreadSeedSalt, InShotSequence);
+}
+
+void ASHitScanWeapon::TracePellets(const FVector& EyeLocation, const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, float RewindTime)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponTracePellets);
+
+	const FCollisionQueryParams QueryParams = GetShotQueryParams(RewindTime >= 0.f);
+
+	// Do line traces from camera to find closest object that can be hit
+	for (FHitScanPellet& Pellet : Pellets)
+	{
+		if (Pellet.bCorrected)
+			continue;
+
+		// End of trace if nothing is hit
+		Pellet.TraceEnd = EyeLocation + (Pellet.ShotDirection * MaxShotDistance);
+
+		Pellet.HitResult = LineTraceShot(QueryParams, EyeLocation, Pellet.TraceEnd);
+		if (Pellet.HitResult.bBlockingHit)
+		{
+			Pellet.TraceEnd = Pellet.HitResult.ImpactPoint;
+		}
+		Pellet.bCameraTraced = true;
+	}
+
+	// Actual bullet line traces from weapon to closest object that can be hit
+	for (FHitScanPellet& Pellet : Pellets)
+	{
+		if (Pellet.bCorrected)
+			continue;
+
+		FHitResult HitResult = LineTraceShot(QueryParams, MuzzleLocation, GetMuzzleTraceEnd(MuzzleLocation, Pellet));
+		ApplyMuzzleTraceResult(Pellet, HitResult.bBlockingHit ? &HitResult : nullptr);
+	}
+
+	if (RewindTime >= 0.f)
+	{
+		ApplyLagCompensation(MuzzleLocation, Pellets, RewindTime);
+	}
+}
+
+FVector ASHitScanWeapon::GetMuzzleTraceEnd(const FVector& MuzzleLocation, const FHitScanPellet& Pellet) const
+{
+	FVector NewEnd = Pellet.TraceEnd + (Pellet.ShotDirection * 10);
+
+	if (TraceMode == EHitScanTraceMode::EHTM_CameraWithMuzzleProbe)
+	{
+		// Only probe the start of the muzzle trace, anything further along is assumed to be what the camera trace found
+		const FVector ToEnd = NewEnd - MuzzleLocation;
+		const float Distance = ToEnd.Size();
+		if (Distance > MuzzleProbeDistance)
+		{
+			NewEnd = MuzzleLocation + ToEnd * (MuzzleProbeDistance / Distance);
+		}
+	}
+
+	return NewEnd;
+}
+
+void ASHitScanWeapon::ApplyMuzzleTraceResult(FHitScanPellet& Pellet, const FHitResult* HitResult) const
+{
+	if (TraceMode == EHitScanTraceMode::EHTM_CameraWithMuzzleProbe)
+	{
+		INC_DWORD_STAT(STAT_WeaponMuzzleProbes);
+
+		if (HitResult == nullptr)
+		{
+			// Muzzle is clear, the camera trace result is the shot result
+			Pellet.bMuzzleHit = Pellet.HitResult.bBlockingHit;
+		}
+		else
+		{
+			// The probe lies on the same ray as the full muzzle trace, so its hit is what the full trace would have hit
+			INC_DWORD_STAT(STAT_WeaponMuzzleProbesBlocked);
+		}
+	}
+
+	if (HitResult)
+	{
+		Pellet.HitResult = *HitResult;
+		Pellet.TraceEnd = HitResult->ImpactPoint;
+		Pellet.bMuzzleHit = true;
+	}
+
+	if (Pellet.bMuzzleHit)
+	{
+		ApplyHitSurface(Pellet);
+	}
+}
+
+void ASHitScanWeapon::ApplyHitSurface(FHitScanPellet& Pellet) const
+{
+	if (CollisionMode == EHitScanCollisionMode::EHCM_Complex)
+	{
+		Pellet.SurfaceType = UPhysicalMaterial::DetermineSurfaceType(Pellet.HitResult.PhysMaterial.Get());
+		Pellet.DamageMultiplier = Pellet.SurfaceType == SURFACE_FLESHVULNERABLE ? 2.f : 1.f; // Multiply damage if hit a vulnerable spot
+		return;
+	}
+
+	// Pawns and bots carry the surface and damage of each body, no physical material lookup needed
+	AActor* HitActor = Pellet.HitResult.GetActor();
+	USHitboxComponent* HitboxComp = HitActor ? HitActor->FindComponentByClass<USHitboxComponent>() : nullptr;
+	if (HitboxComp)
+	{
+		const FSHitboxTag& Tag = HitboxComp->GetTagForBone(Pellet.HitResult.BoneName);
+		Pellet.SurfaceType = Tag.SurfaceType;
+		Pellet.DamageMultiplier = Tag.DamageMultiplier;
+		return;
+	}
+
+	Pellet.DamageMultiplier = 1.f;
+	RefineWorldHit(Pellet);
+}
+
+void ASHitScanWeapon::RefineWorldHit(FHitScanPellet& Pellet) const
+{
+	Pellet.SurfaceType = SurfaceType_Default;
+
+	UPrimitiveComponent* HitComponent = Pellet.HitResult.Component.Get();
+	if (HitComponent == nullptr || HitComponent->Mobility == EComponentMobility::Movable)
+		return;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitScanRefineWorldHit), true);
+	QueryParams.AddIgnoredActor(GetOwner());
+	QueryParams.AddIgnoredActor(this);
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	const FVector ImpactPoint = Pellet.HitResult.ImpactPoint;
+	const FVector Offset = Pellet.ShotDirection * WorldHitRefineDistance;
+
+	FHitResult RefinedHit;
+	INC_DWORD_STAT(STAT_WeaponTraces);
+	if (GetWorld()->LineTraceSingleByChannel(RefinedHit, ImpactPoint - Offset, ImpactPoint + Offset, COLLISION_WEAPON, QueryParams))
+	{
+		Pellet.HitResult.ImpactPoint = RefinedHit.ImpactPoint;
+		Pellet.HitResult.ImpactNormal = RefinedHit.ImpactNormal;
+		Pellet.HitResult.PhysMaterial = RefinedHit.PhysMaterial;
+		Pellet.TraceEnd = RefinedHit.ImpactPoint;
+		Pellet.SurfaceType = UPhysicalMaterial::DetermineSurfaceType(RefinedHit.PhysMaterial.Get());
+	}
+}
+
+void ASHitScanWeapon::ApplyLagCompensation(const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, float RewindTime) const
+{
+	USLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<USLagCompensationSubsystem>();
+	if (LagCompensation == nullptr)
+		return;
+
+	for (FHitScanPellet& Pellet : Pellets)
+	{
+		// The world traces ignored every lag compensated target, so anything rewound along the muzzle trace was hit first
+		FSRewindHit RewindHit;
+		if (!LagCompensation->TraceRewound(RewindTime, MuzzleLocation, Pellet.TraceEnd + (Pellet.ShotDirection * 10), GetOwner(), RewindHit))
+			continue;
+
+		Pellet.HitResult = FHitResult(RewindHit.Actor, RewindHit.Component, RewindHit.ImpactPoint, RewindHit.ImpactNormal);
+		Pellet.HitResult.bBlockingHit = true;
+		Pellet.HitResult.TraceStart = MuzzleLocation;
+		Pellet.HitResult.TraceEnd = Pellet.TraceEnd;
+		Pellet.HitResult.Distance = RewindHit.Distance;
+		Pellet.HitResult.BoneName = RewindHit.BoneName;
+		Pellet.HitResult.PhysMaterial = RewindHit.PhysMaterial;
+		Pellet.TraceEnd = RewindHit.ImpactPoint;
+		Pellet.bMuzzleHit = true;
+
+		// The rewound body carries the surface of its physical material, or the target's own when it has no bodies
+		Pellet.SurfaceType = (EPhysicalSurface)RewindHit.SurfaceType;
+		Pellet.DamageMultiplier = Pellet.SurfaceType == SURFACE_FLESHVULNERABLE ? 2.f : 1.f;
+
+		// Hitboxes are tagged by bone, which the rewound body carries as well
+		if (CollisionMode == EHitScanCollisionMode::EHCM_SimpleHitboxes)
+		{
+			ApplyHitSurface(Pellet);
+		}
+	}
+}
+
+void ASHitScanWeapon::TracePelletsAsync(const FVector& EyeLocation, const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, const FHitScanShotEvent& ShotEvent, float RewindTime)
+{
+	if (!AsyncPelletTraceDelegate.IsBound())
+	{
+		AsyncPelletTraceDelegate.BindUObject(this, &ASHitScanWeapon::OnAsyncPelletTraceCompleted);
+	}
+
+	// A batch without traces would never complete
+	if (Pellets.Num() == 0)
+		return;
+
+	// The lower 8 bits of the trace UserData hold the pellet index, the rest the batch id, BulletsPerFire is clamped to fit
+	LastPelletBatchId = (LastPelletBatchId + 1) & 0xFFFFFF;
+
+	FHitScanPelletBatch& Batch = PendingPelletBatches.Add(LastPelletBatchId);
+	Batch.EyeLocation = EyeLocation;
+	Batch.MuzzleLocation = MuzzleLocation;
+	Batch.QueryParams = GetShotQueryParams(RewindTime >= 0.f);
+	Batch.Pellets = MoveTemp(Pellets);
+	Batch.ShotEvent = ShotEvent;
+	Batch.RewindTime = RewindTime;
+	Batch.OutstandingTraces = Batch.Pellets.Num();
+
+	for (int32 i = 0; i < Batch.Pellets.Num(); i++)
+	{
+		FHitScanPellet& Pellet = Batch.Pellets[i];
+		Pellet.TraceEnd = EyeLocation + (Pellet.ShotDirection * MaxShotDistance);
+
+		INC_DWORD_STAT(STAT_WeaponTraces);
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyeLocation, Pellet.TraceEnd, COLLISION_WEAPON, Batch.QueryParams, FCollisionResponseParams::DefaultResponseParam, &AsyncPelletTraceDelegate, (LastPelletBatchId << 8) | i);
+	}
+}
+
+void ASHitScanWeapon::OnAsyncPelletTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	const uint32 BatchId = TraceDatum.UserData >> 8;
+	const int32 PelletIndex = TraceDatum.UserData & 0xFF;
+
+	FHitScanPelletBatch* Batch = PendingPelletBatches.Find(BatchId);
+	if (Batch == nullptr || !Batch->Pellets.IsValidIndex(PelletIndex))
+		return;
+
+	FHitScanPellet& Pellet = Batch->Pellets[PelletIndex];
+	const FHitResult* HitResult = TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit ? &TraceDatum.OutHits[0] : nullptr;
+
+	if (!Pellet.bCameraTraced)
+	{
+		// Camera trace finished, now trace from the muzzle to the closest object that can be hit
+		Pellet.bCameraTraced = true;
+		if (HitResult)
+		{
+			Pellet.HitResult = *HitResult;
+			Pellet.TraceEnd = HitResult->ImpactPoint;
+		}
+
+		INC_DWORD_STAT(STAT_WeaponTraces);
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Batch->MuzzleLocation, GetMuzzleTraceEnd(Batch->MuzzleLocation, Pellet), COLLISION_WEAPON, Batch->QueryParams, FCollisionResponseParams::DefaultResponseParam, &AsyncPelletTraceDelegate, TraceDatum.UserData);
+		return;
+	}
+
+	ApplyMuzzleTraceResult(Pellet, HitResult);
+
+	Batch->OutstandingTraces--;
+	if (Batch->OutstandingTraces <= 0)
+	{
+		// Owner may have gone away while the traces were in flight
+		if (GetOwner())
+		{
+			if (Batch->RewindTime >= 0.f)
+			{
+				ApplyLagCompensation(Batch->MuzzleLocation, Batch->Pellets, Batch->RewindTime);
+			}
+
+			ResolvePellets(Batch->MuzzleLocation, Batch->Pellets, Batch->ShotEvent);
+		}
+
+		PendingPelletBatches.Remove(BatchId);
+	}
+}
+
+void ASHitScanWeapon::ResolvePellets(const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, FHitScanShotEvent& ShotEvent)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponResolvePellets);
+
+	for (int32 i = 0; i < Pellets.Num(); i++)
+	{
+		FHitScanPellet& Pellet = Pellets[i];
+
+		if (Pellet.bMuzzleHit)
+		{
+			SpawnImpactDecal(Pellet.HitResult, Pellet.SurfaceType);
+		}
+
+		// Only send the impact point when a client's own trace could disagree
+		if (HasAuthority() && ShouldCorrectPellet(Pellet))
+		{
+			ShotEvent.Corrections.Emplace(i, MuzzleLocation, Pellet.TraceEnd, Pellet.SurfaceType);
+		}
+	}
+
+	PlayPelletEffects(Pellets);
+
+	// Every pellet applies its own damage, so the hit bone and surface of each one reach the damage handlers
+	for (const FHitScanPellet& Pellet : Pellets)
+	{
+		if (!Pellet.bMuzzleHit)
+			continue;
+
+		const float ActualDamage = CurrentDamage * Pellet.DamageMultiplier;
+		UGameplayStatics::ApplyPointDamage(Pellet.HitResult.GetActor(), ActualDamage, Pellet.ShotDirection, Pellet.HitResult, GetOwner()->GetInstigatorController(), GetOwner(), GetDefinition()->DamageType);
+	}
+
+	// Server replicates the shot to clients using ShotEvents, the pellets are rebuilt and replayed by PlayShotEvent()
+	if (HasAuthority())
+	{
+		ShotEvents.AddEvent(ShotEvent);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ASHitScanWeapon, ShotEvents, this);
+
+		// Observers play the shot's cosmetics from the event, so it goes out on the next net update rather than within NetUpdateFrequency
+		// Shots fired in the same frame share the update
+		ForceNetUpdate();
+	}
+}
+
+void ASHitScanWeapon::PlayPelletEffects(const TArray<FHitScanPellet>& Pellets)
+{
+	USCosmeticEventSubsystem* Cosmetics = GetWorld()->GetSubsystem<USCosmeticEventSubsystem>();
+	if (Cosmetics == nullptr)
+		return;
+
+	for (const FHitScanPellet& Pellet : Pellets)
+	{
+		Cosmetics->QueueTracer(this, Pellet.TraceEnd);
+
+		if (Pellet.HitResult.bBlockingHit)
+		{
+			PlayImpactEffects(Pellet.SurfaceType, Pellet.HitResult.ImpactPoint);
+		}
+	}
+}
+
+bool ASHitScanWeapon::ShouldCorrectPellet(const FHitScanPellet& Pellet) const
+{
+	// Hits on static geometry are the same on every machine, anything that moves may be somewhere else on clients
+	UPrimitiveComponent* HitComponent = Pellet.HitResult.Component.Get();
+	return Pellet.bMuzzleHit && HitComponent && HitComponent->Mobility == EComponentMobility::Movable;
+}
+
+FCollisionQueryParams ASHitScanWeapon::GetShotQueryParams(bool bIgnoreLagCompensatedTargets) const
+{
+	const bool bComplex = CollisionMode == EHitScanCollisionMode::EHCM_Complex;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitScanShot), bComplex);
+	QueryParams.AddIgnoredActor(GetOwner());
+	QueryParams.AddIgnoredActor(this);
+	QueryParams.bReturnPhysicalMaterial = bComplex;
+
+	if (bIgnoreLagCompensatedTargets)
+	{
+		USLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<USLagCompensationSubsystem>();
+		if (LagCompensation)
+		{
+			QueryParams.AddIgnoredActors(LagCompensation->GetTargetActors());
+		}
+	}
+
+	return QueryParams;
+}
+
+void ASHitScanWeapon::PlayImpactEffects(EPhysicalSurface SurfaceType, FVector ImpactPoint)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponPlayImpactEffects);
+
+	USCosmeticEventSubsystem* Cosmetics = GetWorld()->GetSubsystem<USCosmeticEventSubsystem>();
+	if (Cosmetics == nullptr)
+		return;
+
+	const USWeaponDefinition* WeaponDefinition = GetDefinition();
+
+	if (SurfaceType == SURFACE_METALDEFAULT || SurfaceType == SURFACE_METALVULNERABLE)
+	{
+		Cosmetics->QueueImpact(SurfaceType, WeaponDefinition->MetalImpactEffect.Get(), WeaponDefinition->ImpactSoundMetal.Get(), ImpactPoint);
+		return;
+	}
+
+	UParticleSystem* SelectedParticleEffect;
+	USoundBase* SelectedSoundEffect;
+	switch (SurfaceType)
+	{
+	case SURFACE_FLESHDEFAULT:
+		SelectedParticleEffect = WeaponDefinition->FleshImpactEffect.Get();
+		SelectedSoundEffect = WeaponDefinition->ImpactSoundFlesh.Get();
+		break;
+	case SURFACE_FLESHVULNERABLE:
+		SelectedParticleEffect = WeaponDefinition->FleshImpactEffect.Get();
+		SelectedSoundEffect = WeaponDefinition->ImpactSoundFlesh.Get();
+		break;
+	default:
+		SelectedParticleEffect = WeaponDefinition->DefaultImpactEffect.Get();
+		SelectedSoundEffect = WeaponDefinition->ImpactSoundDefault.Get();
+		break;
+	}
+
+	FVector MuzzleLocation = GetMesh()->GetSocketLocation(MuzzleSocketName);
+	FVector ShotDirection = ImpactPoint - MuzzleLocation;
+	ShotDirection.Normalize();
+
+	// Merged with the other impacts this frame, played at the end of the frame
+	Cosmetics->QueueImpact(SurfaceType, SelectedParticleEffect, SelectedSoundEffect, ImpactPoint, ShotDirection.Rotation());
+}
+
+void ASHitScanWeapon::PlayTracerEffects(FVector TraceEnd)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponPlayTracerEffects);
+
+	UNiagaraSystem* TracerEffect = GetDefinition()->TracerEffect.Get();
+	if (TracerEffect == nullptr || GetNetMode() == NM_DedicatedServer)
+		return;
+
+	FVector MuzzleLocation = Mesh->GetSocketLocation(MuzzleSocketName);
+
+	UNiagaraComponent* TracerComp = nullptr;
+	if (TracerComponents.Num() < TracerPoolSize)
+	{
+		TracerComp = UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, TracerEffect, MuzzleLocation, FRotator::ZeroRotator, FVector(1.f), false);
+		if (TracerComp)
+		{
+			TracerComponents.Add(TracerComp);
+			INC_DWORD_STAT(STAT_WeaponLiveTracerComponents);
+		}
+	}
+	else
+	{
+		// Restart the oldest tracer at the muzzle
+		NextTracerIndex = NextTracerIndex % TracerComponents.Num();
+		TracerComp = TracerComponents[NextTracerIndex++];
+		if (TracerComp)
+		{
+			TracerComp->SetWorldLocation(MuzzleLocation);
+			TracerComp->Activate(true);
+		}
+	}
+
+	if (TracerComp)
+	{
+		TracerComp->SetVectorParameter(TracerTargetName, TraceEnd);
+	}
+}
+
+void ASHitScanWeapon::PlayShotEvent(const FHitScanShotEvent& ShotEvent)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponPlayShotEvent);
+
+	AActor* MyOwner = GetOwner();
+	if (MyOwner == nullptr)
+		return;
+
+	// Shots that arrive late, e.g. when the weapon becomes relevant again, are not replayed
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+	if (GameState && ShotEvent.GetAge(GameState->GetServerWorldTimeSeconds()) > MaxShotEventAge)
+		return;
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	MyOwner->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+	FVector MuzzleLocation = Mesh->GetSocketLocation(MuzzleSocketName);
+
+	// Rebuild the same pellets the server fired
+	TArray<FHitScanPellet> Pellets;
+	BuildPellets(ShotEvent.ShotSequence, ShotEvent.GetAimRotation(), ShotEvent.GetSpread(), (ShotEvent.Flags & FHitScanShotEvent::FLAG_FirstPelletAccurate) != 0, Pellets);
+
+	for (const FHitScanPelletCorrection& Correction : ShotEvent.Corrections)
+	{
+		if (Pellets.IsValidIndex(Correction.PelletIndex))
+		{
+			FHitScanPellet& Pellet = Pellets[Correction.PelletIndex];
+			Pellet.bCorrected = true;
+			Pellet.TraceEnd = Correction.GetImpactPoint(MuzzleLocation);
+			Pellet.SurfaceType = (EPhysicalSurface)Correction.SurfaceType;
+			Pellet.HitResult.bBlockingHit = true;
+			Pellet.HitResult.ImpactPoint = Pellet.TraceEnd;
+		}
+	}
+
+	TracePellets(EyeLocation, MuzzleLocation, Pellets);
+
+	// Play cosmetic effects
+	PlayFireEffect();
+	PlayPelletEffects(Pellets);
+}
+
+float ASHitScanWeapon::UpdateBulletSpread(float ShotTime, bool& bOutFirstPelletAccurate)
+{
+	// Heat recovers from the time since the last shot, so nothing needs to run between shots
+	const float Heat = GetSpreadHeat(ShotTime);
+	const bool bIsADS = OwningPawn->IsAimingDownSights();
+
+	bOutFirstPelletAccurate = Heat <= 0.f && bIsADS && bHasFirstShotAccuracy;
+
+	// Every spread pellet adds heat, as it did when each pellet was spread on its own, so shotguns still heat up faster
+	const int32 NumSpreadPellets = BulletsPerFire - (bOutFirstPelletAccurate ? 1 : 0);
+	SpreadHeat = FMath::Min(Heat + NumSpreadPellets, SpreadHeatLimit);
+	LastSpreadTime = ShotTime;
+
+	return bIsADS ? SpreadLookupADS.Evaluate(SpreadHeat) : SpreadLookup.Evaluate(SpreadHeat);
+}
+
+float ASHitScanWeapon::GetSpreadHeat(float Time) const
+{
+	const float TimeSinceLastShot = Time - LastSpreadTime;
+	return SpreadHeat * SpreadRecoveryLookup.Evaluate(TimeSinceLastShot / FMath::Max(TimeBetweenAccurateShots, KINDA_SMALL_NUMBER));
+}
+
+void ASHitScanWeapon::ApplyRecoil()
+{
+	// AI aims with its own controller, kicking it would only throw its aim off
+	if (OwningPawn == nullptr || !OwningPawn->IsLocallyControlled() || !OwningPawn->IsPlayerControlled())
+		return;
+
+	float Kick = RecoilLookup.Evaluate(SpreadHeat);
+	if (OwningPawn->IsAimingDownSights())
+	{
+		Kick *= RecoilScaleADS;
+	}
+
+	AController* Controller = OwningPawn->GetController();
+	if (Controller && Kick != 0.f)
+	{
+		Controller->SetControlRotation(Controller->GetControlRotation() + FRotator(Kick, 0.f, 0.f));
+	}
+}
+
+void ASHitScanWeapon::StartFire()
+{
+	// The crosshair resets when the spread has recovered after the trigger is released, not while firing
+	GetWorldTimerManager().ClearTimer(TimerHandle_FirstShotAccuracy);
+
+	Super::StartFire();
+}
+
+void ASHitScanWeapon::ResetForPool()
+{
+	Super::ResetForPool();
+
+	GetWorldTimerManager().ClearTimer(TimerHandle_FirstShotAccuracy);
+	SpreadHeat = 0.f;
+	LastSpreadTime = 0.f;
+
+	// Traces still in flight belong to the last owner, their results are dropped when they arrive
+	PendingPelletBatches.Empty();
+
+	// Clients that keep the weapon relevant must not replay the last owner's shots for the next one
+	ShotEvents.Reset();
+	MARK_PROPERTY_DIRTY_FROM_NAME(ASHitScanWeapon, ShotEvents, this);
+}
+
+#if WITH_EDITORONLY_DATA
+void ASHitScanWeapon::CopyDeprecatedSettings(USWeaponDefinition* NewDefinition) const
+{
+	Super::CopyDeprecatedSettings(NewDefinition);
+
+	NewDefinition->TracerEffect = TracerEffect_DEPRECATED;
+}
+#endif
+
+void ASHitScanWeapon::StopFire()
+{
+	Super::StopFire();
+
+	const float TimeUntilRecovered = LastFireTime + TimeBetweenAccurateShots - GetWorld()->TimeSeconds;
+	if (TimeUntilRecovered > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(TimerHandle_FirstShotAccuracy, this, &ASHitScanWeapon::ResetFirstShotAccuracy, TimeUntilRecovered);
+	}
+	else
+	{
+		ResetFirstShotAccuracy();
+	}
+}
+
+FHitResult ASHitScanWeapon::LineTraceShot(const FCollisionQueryParams& QueryParams, const FVector& StartLocation, const FVector& EndLocation)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponLineTraceShot);
+	INC_DWORD_STAT(STAT_WeaponTraces);
+
+	FHitResult HitResult;
+	GetWorld()->LineTraceSingleByChannel(HitResult, StartLocation, EndLocation, COLLISION_WEAPON, QueryParams);
+
+	return HitResult;
+}
+
+
+void ASHitScanWeapon::ResetFirstShotAccuracy()
+{
+	ResetWeaponFireSpread();
+}
+
+bool ASHitScanWeapon::SurfaceTypeIsVunerable(EPhysicalSurface PhysicalSurface)
+{
+	return PhysicalSurface == SURFACE_FLESHVULNERABLE 
+		|| PhysicalSurface == SURFACE_METALVULNERABLE;
+}
+
+void ASHitScanWeapon::SpawnImpactDecal(const FHitResult& HitResult, EPhysicalSurface SurfaceType)
+{
+	UMaterialInterface* BulletHitDecal = GetDefinition()->BulletHitDecal.Get();
+	if (BulletHitDecal)
+	{
+		USImpactDecalSubsystem* DecalSubsystem = GetWorld()->GetSubsystem<USImpactDecalSubsystem>();
+		if (DecalSubsystem)
+		{
+			DecalSubsystem->SpawnImpactDecal(BulletHitDecal, FVector(2.5f), HitResult, SurfaceType);
+		}
+	}
+}
+
+void ASHitScanWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ASHitScanWeapon, ShotEvents, Params);
+}
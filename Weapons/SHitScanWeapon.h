@@ -1,125 +1,566 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "SWeapon.h"
-#include "SHitScanWeapon.generated.h"
-
-class UNiagaraSystem;
-
-/**
-** Contains information of a single hitscan weapon linetrace 
-*/
-USTRUCT()
-struct FHitScanTrace
-{
-	GENERATED_BODY()
-
-public:
-
-	/** The surface the linetrace hit */
-	UPROPERTY()
-	TEnumAsByte<EPhysicalSurface> SurfaceType;
-
-	/** The location the linetrace hit */
-	UPROPERTY()
-	FVector_NetQuantize TraceEnd;
-
-	/** Used to force replication even if the other values haven't changed */
-	UPROPERTY()
-	uint8 ReplicationCount;
-};
-
-
-UCLASS()
-class COOPHORDE_API ASHitScanWeapon : public ASWeapon
-{
-	GENERATED_BODY()
-	
-public:
-
-	ASHitScanWeapon();
-
-protected:
-
-	/** The parameter name in Target of the TracerEffect */
-	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = Weapon)
-	FName TracerTargetName;
-
-	/** Tracer effect used when the weapon is fired */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
-	UNiagaraSystem* TracerEffect;
-
-	/** Information about a single hitscan line trace */
-	UPROPERTY(ReplicatedUsing = OnRep_HitScanTrace)
-	FHitScanTrace HitScanTrace;
-
-	/** The maximum distance the shot line trace will go */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats)
-	float MaxShotDistance;
-
-	/** Time needed between weapon fire for the shot to be accurate */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats, meta = (ClampMin = 0.f))
-	float TimeBetweenAccurateShots;
-
-	/** Whether or not the first shot will be 100% accurate to where the player is aiming */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats)
-	bool bHasFirstShotAccuracy;
-
-	/** If true every show will become increasingly less accurate until BulletSpread or BulletSpreadADS is reached, if false the max values will be used from the first shot*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats)
-	bool bDecreaseAccuracyPerShot;
-
-	/** The number of shots fired in the current spray, used to reduce accuracy the longer the weapon is fired */
-	float ShotsFiredThisSpread;
-
-	/** TimerHandle for shot accuracy spread */
-	FTimerHandle TimerHandle_FirstShotAccuracy;
-
-	/** Bullet spread in degrees */
-	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
-	float BulletSpread;
-
-	/** Bullet spread in degrees when aiming downing sights */
-	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
-	float BulletSpreadADS;
-
-	/** The number of bullets shot every time the weapon is fired */
-	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
-	int32 BulletsPerFire;
-
-	float CurrentBulletSpread;
-
-protected:
-
-	virtual void BeginPlay() override;
-
-	/** Called when the weapon is fired */
-	virtual void Fire() override;
-
-	/** Fires a bullet for BulletsPerFire */
-	void FireBullet(FVector ShotDirection, FVector EyeLocation, FVector MuzzleLocation);
-
-	/** Plays the ImpactEffect at the line trace */
-	void PlayImpactEffects(EPhysicalSurface SurfaceType, FVector ImpactPoint);
-
-	/** Plays the TracerEffect from the weapon to line trace hit location */
-	void PlayTracerEffects(FVector TraceEnd);
-
-	/** Replication function for HitScanTrace */
-	UFUNCTION()
-	void OnRep_HitScanTrace();
-
-	/** Add bullet spread to shot and handle first shot accuracy */
-	FVector AddBulletSpread(FVector ShotDirection);
-
-	/** Create line trace */
-	FHitResult LineTraceShot(AActor* MyOwner, FVector& StartLocation, FVector& EndLocation);
-
-	void ResetFirstShotAccuracy();
-
-	bool SurfaceTypeIsVunerable(EPhysicalSurface PhysicalSurface);
-
-	void SpawnImpactDecal(FHitResult HitResult);
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SWeapon.h"
+#include "WorldCollision.h"
+#include "Engine/NetSerialization.h"
+#include "SHitScanWeapon.generated.h"
+
+class UNiagaraSystem;
+class UNiagaraComponent;
+class UCurveFloat;
+
+/**
+* How the shot of a hitscan weapon is traced
+*/
+UENUM()
+enum class EHitScanTraceMode : uint8
+{
+	/** Trace from the camera to find the aim point, then from the muzzle to the aim point to find what is actually hit */
+	EHTM_CameraAndMuzzle,
+	/** Trace from the camera only, and probe a short distance in front of the muzzle to check it isn't blocked */
+	EHTM_CameraWithMuzzleProbe
+};
+
+/**
+* What the shot traces of a hitscan weapon collide with
+*/
+UENUM()
+enum class EHitScanCollisionMode : uint8
+{
+	/** Trace complex collision and read the surface from the physical material of the hit */
+	EHCM_Complex,
+	/** Trace simple collision, pawns and bots are hit on their physics bodies and the surface and damage come from their USHitboxComponent */
+	EHCM_SimpleHitboxes
+};
+
+class ASHitScanWeapon;
+struct FHitScanShotEventArray;
+
+/**
+** The server's impact point for a single pellet of a replicated shot
+** Stored relative to the muzzle as a quantized direction and distance
+*/
+USTRUCT()
+struct FHitScanPelletCorrection
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The index of the corrected pellet in the shot */
+	UPROPERTY()
+	uint8 PelletIndex;
+
+	/** The surface the pellet hit */
+	UPROPERTY()
+	uint8 SurfaceType;
+
+	/** Yaw of the direction from the muzzle to the impact point, compressed to a short */
+	UPROPERTY()
+	uint16 DirectionYaw;
+
+	/** Pitch of the direction from the muzzle to the impact point, compressed to a short */
+	UPROPERTY()
+	uint16 DirectionPitch;
+
+	/** Distance from the muzzle to the impact point in 2cm steps */
+	UPROPERTY()
+	uint16 Distance;
+
+	FHitScanPelletCorrection()
+		: PelletIndex(0)
+		, SurfaceType(SurfaceType_Default)
+		, DirectionYaw(0)
+		, DirectionPitch(0)
+		, Distance(0)
+	{}
+
+	/** Creates a correction for pellet InPelletIndex fired from MuzzleLocation that hit ImpactPoint */
+	FHitScanPelletCorrection(int32 InPelletIndex, const FVector& MuzzleLocation, const FVector& ImpactPoint, EPhysicalSurface InSurfaceType);
+
+	/** Returns the impact point of the pellet when fired from MuzzleLocation */
+	FVector GetImpactPoint(const FVector& MuzzleLocation) const;
+
+	/** Packs the correction into 62 bits */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+/**
+** A single replicated hitscan shot
+** Only the spread seed, fire time and aim are sent, clients rebuild the pellets with the same seeded spread as the server and trace them locally
+** Pellets that hit something moving, where the client's trace could disagree with the server, carry a correction with the server's impact point
+*/
+USTRUCT()
+struct FHitScanShotEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Flag set when the first pellet of the shot ignores bullet spread */
+	static const uint8 FLAG_FirstPelletAccurate = 1 << 0;
+
+	/** The shot sequence number of the weapon when fired, seeds the bullet spread */
+	UPROPERTY()
+	uint16 ShotSequence;
+
+	/** The server world time the shot was fired, in hundredths of a second wrapped to 16 bits */
+	UPROPERTY()
+	uint16 FireTime;
+
+	/** Yaw of the aim rotation, compressed to a short */
+	UPROPERTY()
+	uint16 AimYaw;
+
+	/** Pitch of the aim rotation, compressed to a short */
+	UPROPERTY()
+	uint16 AimPitch;
+
+	/** Bullet spread of the shot in 0.05 degree steps */
+	UPROPERTY()
+	uint8 Spread;
+
+	/** FLAG_ bits of this shot */
+	UPROPERTY()
+	uint8 Flags;
+
+	/** Server impact points of the pellets clients can't reproduce */
+	UPROPERTY()
+	TArray<FHitScanPelletCorrection> Corrections;
+
+	FHitScanShotEvent()
+		: ShotSequence(0)
+		, FireTime(0)
+		, AimYaw(0)
+		, AimPitch(0)
+		, Spread(0)
+		, Flags(0)
+	{}
+
+	/** Creates an event for a shot, aim and spread are quantized so must be read back with GetAimRotation() and GetSpread() before being used to build the pellets */
+	FHitScanShotEvent(uint16 InShotSequence, float ServerWorldTime, const FRotator& AimRotation, float InSpread, uint8 InFlags);
+
+	/** Returns the quantized aim rotation */
+	FRotator GetAimRotation() const;
+
+	/** Returns the quantized bullet spread in degrees */
+	float GetSpread() const;
+
+	/** Returns how long ago the shot was fired, given the current server world time */
+	float GetAge(float ServerWorldTime) const;
+
+	/** Packs the event into 73 bits plus the corrections */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	/** Plays the cosmetic effects of the shot on clients */
+	void PostReplicatedAdd(const FHitScanShotEventArray& InArraySerializer);
+	void PostReplicatedChange(const FHitScanShotEventArray& InArraySerializer);
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitScanPelletCorrection> : public TStructOpsTypeTraitsBase2<FHitScanPelletCorrection>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitScanShotEvent> : public TStructOpsTypeTraitsBase2<FHitScanShotEvent>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+** Fixed size ring buffer of the most recent shot events of a weapon, replicated as a fast array
+** so every shot fired between two net updates reaches clients in one bunch
+*/
+USTRUCT()
+struct FHitScanShotEventArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The maximum number of events kept before the oldest is overwritten */
+	static const int32 Capacity = 32;
+
+	/** The events in the ring buffer */
+	UPROPERTY()
+	TArray<FHitScanShotEvent> Events;
+
+	/** The weapon these events belong to */
+	UPROPERTY(NotReplicated)
+	ASHitScanWeapon* Owner;
+
+	/** The next index in Events that will be written to once the buffer is full */
+	int32 NextEventIndex;
+
+	FHitScanShotEventArray()
+		: Owner(nullptr)
+		, NextEventIndex(0)
+	{}
+
+	/** Adds Event to the buffer, overwriting the oldest event if it is full */
+	void AddEvent(const FHitScanShotEvent& Event);
+
+	/** Removes every event */
+	void Reset();
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FHitScanShotEvent, FHitScanShotEventArray>(Events, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FHitScanShotEventArray> : public TStructOpsTypeTraitsBase2<FHitScanShotEventArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
+/**
+** A single pellet of a hitscan shot, filled in as the shot is traced and resolved
+*/
+struct FHitScanPellet
+{
+	/** The direction of the pellet after bullet spread has been added */
+	FVector ShotDirection;
+
+	/** The end of the camera trace, used as the target of the muzzle trace and as the tracer end point */
+	FVector TraceEnd;
+
+	/** The closest thing the pellet hit, from the muzzle trace if it hit something otherwise from the camera trace */
+	FHitResult HitResult;
+
+	/** Whether the muzzle trace hit something, only those hits cause damage and decals */
+	bool bMuzzleHit;
+
+	/** Whether the camera trace has completed, used when tracing asynchronously */
+	bool bCameraTraced;
+
+	/** Whether the result came from the server in a FHitScanPelletCorrection, corrected pellets aren't traced */
+	bool bCorrected;
+
+	/** The surface the pellet hit */
+	EPhysicalSurface SurfaceType;
+
+	/** Damage dealt by the pellet is multiplied by this */
+	float DamageMultiplier;
+
+	FHitScanPellet(const FVector& InShotDirection)
+		: ShotDirection(InShotDirection)
+		, TraceEnd(FVector::ZeroVector)
+		, bMuzzleHit(false)
+		, bCameraTraced(false)
+		, bCorrected(false)
+		, SurfaceType(SurfaceType_Default)
+		, DamageMultiplier(1.f)
+	{}
+};
+
+/**
+** A curve sampled at even steps when the weapon begins play, so evaluating it on every shot is a single lerp between two samples
+*/
+struct FHitScanCurveLookup
+{
+	/** Values of the curve at even steps from 0 to MaxInput */
+	TArray<float> Samples;
+
+	/** The input of the last sample, inputs past it return the last sample */
+	float MaxInput;
+
+	FHitScanCurveLookup()
+		: MaxInput(1.f)
+	{}
+
+	/** Samples Curve, or Fallback when no curve is set, NumSamples times from 0 to InMaxInput */
+	void Bake(const UCurveFloat* Curve, float InMaxInput, int32 NumSamples, TFunctionRef<float(float)> Fallback);
+
+	/** Returns the baked value at Input */
+	float Evaluate(float Input) const;
+};
+
+/**
+** All the pellets of a single trigger pull that are being traced asynchronously
+*/
+struct FHitScanPelletBatch
+{
+	/** Where the camera traces start from */
+	FVector EyeLocation;
+
+	/** Where the muzzle traces start from */
+	FVector MuzzleLocation;
+
+	/** Query params shared by every trace in the batch */
+	FCollisionQueryParams QueryParams;
+
+	/** The pellets being traced */
+	TArray<FHitScanPellet> Pellets;
+
+	/** The event replicated for the shot once it is resolved */
+	FHitScanShotEvent ShotEvent;
+
+	/** The server time lag compensated targets are rewound to, negative when the shot is not rewound */
+	float RewindTime;
+
+	/** The number of muzzle traces that haven't completed yet */
+	int32 OutstandingTraces;
+};
+
+
+UCLASS()
+class COOPHORDE_API ASHitScanWeapon : public ASWeapon
+{
+	GENERATED_BODY()
+	
+public:
+
+	ASHitScanWeapon();
+
+protected:
+
+	/** The parameter name in Target of the definition's TracerEffect */
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FName TracerTargetName;
+
+#if WITH_EDITORONLY_DATA
+	// Tracer from before it moved to the definition, copied into a generated one by PostLoad()
+	UPROPERTY()
+	UNiagaraSystem* TracerEffect_DEPRECATED;
+#endif
+
+	/** The maximum number of tracer components kept by this weapon, should be at least BulletsPerFire so every pellet of a shot has a tracer */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon, meta = (ClampMin = 1))
+	int32 TracerPoolSize;
+
+	/** Persistent components playing the TracerEffect, reused in order once TracerPoolSize is reached */
+	UPROPERTY(Transient)
+	TArray<UNiagaraComponent*> TracerComponents;
+
+	/** The index in TracerComponents used by the next tracer */
+	int32 NextTracerIndex;
+
+	/** The most recent shots fired, replicated to clients to rebuild the pellets and play the cosmetic effects */
+	UPROPERTY(Replicated)
+	FHitScanShotEventArray ShotEvents;
+
+	/** The maximum distance the shot line trace will go */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats)
+	float MaxShotDistance;
+
+	/** Time needed between weapon fire for the shot to be accurate, and for the spread to fully recover */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats, meta = (ClampMin = 0.f))
+	float TimeBetweenAccurateShots;
+
+	/** Bullet spread in degrees from the hip by the heat of the spray, the number of recent shots. If not set the spread grows by BulletSpreadPerShot up to BulletSpread */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	UCurveFloat* SpreadCurve;
+
+	/** Bullet spread in degrees when aiming down sights by the heat of the spray. If not set the spread grows by BulletSpreadPerShot up to BulletSpreadADS */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	UCurveFloat* SpreadCurveADS;
+
+	/** The fraction of the spray's heat kept by the time since the last shot, divided by TimeBetweenAccurateShots. If not set all the heat is kept until TimeBetweenAccurateShots has passed */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	UCurveFloat* SpreadRecoveryCurve;
+
+	/** Degrees the owner's aim is kicked up by the heat of the spray, no recoil is applied if not set */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	UCurveFloat* RecoilCurve;
+
+	/** Scales the RecoilCurve when aiming down sights */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
+	float RecoilScaleADS;
+
+	/** The heat past which the spread and recoil curves stop changing. Without a spread curve the heat can grow further, until the spread reaches BulletSpread or BulletSpreadADS */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 1.f))
+	float MaxSpreadHeat;
+
+	/** Spread added by every shot when no spread curve is set */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
+	float BulletSpreadPerShot;
+
+	/** Whether or not the first shot will be 100% accurate to where the player is aiming */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats)
+	bool bHasFirstShotAccuracy;
+
+	/** If true every show will become increasingly less accurate until BulletSpread or BulletSpreadADS is reached, if false the max values will be used from the first shot*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Stats)
+	bool bDecreaseAccuracyPerShot;
+
+	/** The heat of the spray right after the last shot, it recovers lazily from LastSpreadTime when the next shot is fired */
+	float SpreadHeat;
+
+	/** The server world time of the last shot, the owner and the server both use the time the owner fired at so their heat stays the same */
+	float LastSpreadTime;
+
+	/** The most heat the spray can build up, MaxSpreadHeat or the heat the linear spread needs to reach its maximum. Set by BakeSpreadCurves() */
+	float SpreadHeatLimit;
+
+	/** Resets the crosshair once the spread has recovered, set once when the trigger is released */
+	FTimerHandle TimerHandle_FirstShotAccuracy;
+
+	/** SpreadCurve baked when the weapon begins play */
+	FHitScanCurveLookup SpreadLookup;
+
+	/** SpreadCurveADS baked when the weapon begins play */
+	FHitScanCurveLookup SpreadLookupADS;
+
+	/** SpreadRecoveryCurve baked when the weapon begins play */
+	FHitScanCurveLookup SpreadRecoveryLookup;
+
+	/** RecoilCurve baked when the weapon begins play */
+	FHitScanCurveLookup RecoilLookup;
+
+	/** Bullet spread in degrees */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
+	float BulletSpread;
+
+	/** Bullet spread in degrees when aiming downing sights */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f))
+	float BulletSpreadADS;
+
+	/** The number of bullets shot every time the weapon is fired */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f, ClampMax = 255.f))
+	int32 BulletsPerFire;
+
+	/** Combined with the shot sequence to seed the bullet spread, the same on every machine */
+	uint32 SpreadSeedSalt;
+
+	/** How each pellet of a shot is traced */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	EHitScanTraceMode TraceMode;
+
+	/** What the shot traces collide with */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	EHitScanCollisionMode CollisionMode;
+
+	/** How far either side of a static world hit is traced against complex collision to place the decal when using EHCM_SimpleHitboxes */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f, EditCondition = "CollisionMode == EHitScanCollisionMode::EHCM_SimpleHitboxes"))
+	float WorldHitRefineDistance;
+
+	/** How far in front of the muzzle is checked for blocking objects when using EHTM_CameraWithMuzzleProbe */
+	UPROPERTY(EditDefaultsOnly, Category = Stats, meta = (ClampMin = 0.f, EditCondition = "TraceMode == EHitScanTraceMode::EHTM_CameraWithMuzzleProbe"))
+	float MuzzleProbeDistance;
+
+	/** If true every pellet of a shot is traced asynchronously as one batch and resolved once all the results are in, so damage lands a frame or two after firing. If false the pellets are traced and resolved on the frame they are fired */
+	UPROPERTY(EditDefaultsOnly, Category = Stats)
+	bool bUseAsyncPelletTraces;
+
+	/** Batches of pellets waiting on async trace results, keyed by batch id */
+	TMap<uint32, FHitScanPelletBatch> PendingPelletBatches;
+
+	/** The id given to the last async pellet batch */
+	uint32 LastPelletBatchId;
+
+	/** Bound to OnAsyncPelletTraceCompleted() */
+	FTraceDelegate AsyncPelletTraceDelegate;
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Called when the weapon is fired */
+	virtual void Fire(const FSWeaponShot& Shot) override;
+
+	virtual void StartFire() override;
+
+	virtual void StopFire() override;
+
+	virtual void ResetForPool() override;
+
+#if WITH_EDITORONLY_DATA
+	virtual void CopyDeprecatedSettings(USWeaponDefinition* NewDefinition) const override;
+#endif
+
+	/** Samples the spread, recovery and recoil curves into their lookup tables */
+	void BakeSpreadCurves();
+
+	/** Returns the heat of the spray at Time, recovered from SpreadHeat by the time since LastSpreadTime */
+	float GetSpreadHeat(float Time) const;
+
+	/** Fills OutPellets with BulletsPerFire pellets spread around AimRotation, seeded by InShotSequence so every machine builds the same pellets */
+	void BuildPellets(uint16 InShotSequence, const FRotator& AimRotation, float Spread, bool bFirstPelletAccurate, TArray<FHitScanPellet>& OutPellets) const;
+
+	/** Returns the seed of the bullet spread of shot InShotSequence */
+	int32 GetSpreadSeed(uint16 InShotSequence) const;
+
+	/** Traces every pellet, first all the camera traces and then all the muzzle traces, against lag compensated targets rewound to RewindTime if it isn't negative */
+	void TracePellets(const FVector& EyeLocation, const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, float RewindTime = -1.f);
+
+	/** Submits every pellet as a single batch of async traces, ResolvePellets() is called once they have all completed */
+	void TracePelletsAsync(const FVector& EyeLocation, const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, const FHitScanShotEvent& ShotEvent, float RewindTime);
+
+	/** Bound to AsyncPelletTraceDelegate, handles the result of a single async pellet trace */
+	void OnAsyncPelletTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** Returns where the muzzle trace of Pellet ends, depending on the TraceMode */
+	FVector GetMuzzleTraceEnd(const FVector& MuzzleLocation, const FHitScanPellet& Pellet) const;
+
+	/** Updates Pellet with the result of its muzzle trace, HitResult is null if the trace didn't hit anything */
+	void ApplyMuzzleTraceResult(FHitScanPellet& Pellet, const FHitResult* HitResult) const;
+
+	/** Sets the surface and damage multiplier of Pellet from what it hit */
+	void ApplyHitSurface(FHitScanPellet& Pellet) const;
+
+	/** Traces a short distance either side of a simple collision hit on the static world against complex collision, for accurate decals and surfaces */
+	void RefineWorldHit(FHitScanPellet& Pellet) const;
+
+	/** Replaces the result of every muzzle trace that passes through a lag compensated target as it was at RewindTime */
+	void ApplyLagCompensation(const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, float RewindTime) const;
+
+	/** Applies damage, decals, effects and replication for every traced pellet in one pass */
+	void ResolvePellets(const FVector& MuzzleLocation, TArray<FHitScanPellet>& Pellets, FHitScanShotEvent& ShotEvent);
+
+	/** Queues the tracer and impact effects of every pellet with the USCosmeticEventSubsystem */
+	void PlayPelletEffects(const TArray<FHitScanPellet>& Pellets);
+
+	/** Whether clients might not reproduce the result of Pellet, in which case the server replicates its impact point */
+	bool ShouldCorrectPellet(const FHitScanPellet& Pellet) const;
+
+	/** Returns the query params used by every shot trace, lag compensated targets are ignored when they are traced separately */
+	FCollisionQueryParams GetShotQueryParams(bool bIgnoreLagCompensatedTargets = false) const;
+
+	/** Queues the ImpactEffect at the line trace with the USCosmeticEventSubsystem */
+	void PlayImpactEffects(EPhysicalSurface SurfaceType, FVector ImpactPoint);
+
+public:
+
+	/** Plays the TracerEffect from the weapon to line trace hit location */
+	virtual void PlayTracerEffects(FVector TraceEnd) override;
+
+	/** Rebuilds the pellets of a replicated shot and plays their cosmetic effects */
+	void PlayShotEvent(const FHitScanShotEvent& ShotEvent);
+
+protected:
+
+	/** Adds a heat per spread pellet of a shot fired at the server world time ShotTime to the spray, and returns its bullet spread. Handles first shot accuracy */
+	float UpdateBulletSpread(float ShotTime, bool& bOutFirstPelletAccurate);
+
+	/** Kicks the aim of a locally controlled player owner up by the RecoilCurve */
+	void ApplyRecoil();
+
+	/** Create line trace */
+	FHitResult LineTraceShot(const FCollisionQueryParams& QueryParams, const FVector& StartLocation, const FVector& EndLocation);
+
+	/** Resets the crosshair spread once the spread has recovered */
+	void ResetFirstShotAccuracy();
+
+	bool SurfaceTypeIsVunerable(EPhysicalSurface PhysicalSurface);
+
+	/** Places the BulletHitDecal at the impact point of HitResult through the USImpactDecalSubsystem */
+	void SpawnImpactDecal(const FHitResult& HitResult, EPhysicalSurface SurfaceType);
+};
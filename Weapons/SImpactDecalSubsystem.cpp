@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SImpactDecalSubsystem.h"
+#include "Components/DecalComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "SWeaponStats.h"
+
+static int32 ImpactDecalBudget = 96;
+FAutoConsoleVariableRef CVARImpactDecalBudget(
+	TEXT("COOP.ImpactDecalBudget"),
+	ImpactDecalBudget,
+	TEXT("The maximum number of bullet impact decals in the world"),
+	ECVF_Default);
+
+static int32 ImpactDecalBudgetPerSurface = 48;
+FAutoConsoleVariableRef CVARImpactDecalBudgetPerSurface(
+	TEXT("COOP.ImpactDecalBudgetPerSurface"),
+	ImpactDecalBudgetPerSurface,
+	TEXT("The maximum number of bullet impact decals on a single physical surface type"),
+	ECVF_Default);
+
+/** Decals whose parent hasn't been on screen for this long are recycled before older visible decals */
+static const float DecalNotVisibleTime = 2.f;
+
+UDecalComponent* USImpactDecalSubsystem::SpawnImpactDecal(UMaterialInterface* DecalMaterial, const FVector& DecalSize, const FHitResult& HitResult, EPhysicalSurface SurfaceType)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponSpawnImpactDecal);
+
+	UWorld* World = GetWorld();
+	if (DecalMaterial == nullptr || World == nullptr || World->IsNetMode(NM_DedicatedServer))
+		return nullptr;
+
+	INC_DWORD_STAT(STAT_WeaponDecalsPlaced);
+
+	// Forget decals that were destroyed from outside the subsystem
+	const int32 NumRemoved = Decals.RemoveAll([](const FSPooledDecal& PooledDecal) { return PooledDecal.Decal == nullptr || PooledDecal.Decal->IsPendingKill(); });
+	DEC_DWORD_STAT_BY(STAT_WeaponLiveImpactDecals, NumRemoved);
+
+	const int32 RecycleIndex = FindDecalToRecycle(SurfaceType);
+
+	FSPooledDecal* PooledDecal = nullptr;
+	if (RecycleIndex == INDEX_NONE)
+	{
+		UDecalComponent* Decal = UGameplayStatics::SpawnDecalAtLocation(World, DecalMaterial, DecalSize, HitResult.ImpactPoint, HitResult.ImpactNormal.Rotation());
+		if (Decal == nullptr)
+			return nullptr;
+
+		Decal->SetFadeScreenSize(0.002f);
+
+		PooledDecal = &Decals.AddDefaulted_GetRef();
+		PooledDecal->Decal = Decal;
+		INC_DWORD_STAT(STAT_WeaponLiveImpactDecals);
+	}
+	else
+	{
+		PooledDecal = &Decals[RecycleIndex];
+
+		UDecalComponent* Decal = PooledDecal->Decal;
+		Decal->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+		Decal->SetDecalMaterial(DecalMaterial);
+		Decal->DecalSize = DecalSize;
+		Decal->SetWorldLocationAndRotation(HitResult.ImpactPoint, HitResult.ImpactNormal.Rotation());
+		Decal->MarkRenderStateDirty();
+	}
+
+	PooledDecal->SurfaceType = SurfaceType;
+	PooledDecal->PlacedTime = World->TimeSeconds;
+
+	UPrimitiveComponent* HitComponent = HitResult.Component.Get();
+	if (HitComponent)
+	{
+		PooledDecal->Decal->AttachToComponent(HitComponent, FAttachmentTransformRules::KeepWorldTransform, HitResult.BoneName);
+	}
+
+	return PooledDecal->Decal;
+}
+
+int32 USImpactDecalSubsystem::FindDecalToRecycle(EPhysicalSurface SurfaceType) const
+{
+	const float TimeSeconds = GetWorld()->TimeSeconds;
+
+	int32 OldestIndex = INDEX_NONE;
+	int32 OldestOnSurfaceIndex = INDEX_NONE;
+	int32 OldestNotVisibleIndex = INDEX_NONE;
+	int32 NumOnSurface = 0;
+
+	for (int32 i = 0; i < Decals.Num(); i++)
+	{
+		const FSPooledDecal& PooledDecal = Decals[i];
+
+		if (OldestIndex == INDEX_NONE || PooledDecal.PlacedTime < Decals[OldestIndex].PlacedTime)
+		{
+			OldestIndex = i;
+		}
+
+		if (PooledDecal.SurfaceType == SurfaceType)
+		{
+			NumOnSurface++;
+			if (OldestOnSurfaceIndex == INDEX_NONE || PooledDecal.PlacedTime < Decals[OldestOnSurfaceIndex].PlacedTime)
+			{
+				OldestOnSurfaceIndex = i;
+			}
+		}
+
+		// Decals on something that is gone or hasn't been seen for a while are the least visible
+		const UPrimitiveComponent* Parent = Cast<UPrimitiveComponent>(PooledDecal.Decal->GetAttachParent());
+		const bool bNotVisible = Parent && (Parent->IsPendingKill() || TimeSeconds - Parent->GetLastRenderTimeOnScreen() > DecalNotVisibleTime);
+
+		if (bNotVisible && (OldestNotVisibleIndex == INDEX_NONE || PooledDecal.PlacedTime < Decals[OldestNotVisibleIndex].PlacedTime))
+		{
+			OldestNotVisibleIndex = i;
+		}
+	}
+
+	if (NumOnSurface >= FMath::Max(ImpactDecalBudgetPerSurface, 1))
+	{
+		return OldestOnSurfaceIndex;
+	}
+
+	if (Decals.Num() < FMath::Max(ImpactDecalBudget, 1))
+	{
+		return INDEX_NONE;
+	}
+
+	return OldestNotVisibleIndex != INDEX_NONE ? OldestNotVisibleIndex : OldestIndex;
+}
+
+void USImpactDecalSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_WeaponLiveImpactDecals, Decals.Num());
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SImpactDecalSubsystem.generated.h"
+
+class UDecalComponent;
+class UMaterialInterface;
+
+/**
+* A decal component owned by the USImpactDecalSubsystem
+*/
+USTRUCT()
+struct FSPooledDecal
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(Transient)
+	UDecalComponent* Decal;
+
+	/** The surface the decal was last placed on */
+	uint8 SurfaceType;
+
+	/** The world time the decal was last placed */
+	float PlacedTime;
+
+	FSPooledDecal()
+		: Decal(nullptr)
+		, SurfaceType(SurfaceType_Default)
+		, PlacedTime(0.f)
+	{}
+};
+
+/**
+* Owns every bullet impact decal in the world
+* Decals are recycled once the global or per surface budget is reached, so the number of decal components stays flat however long a match runs
+*/
+UCLASS()
+class COOPHORDE_API USImpactDecalSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Places a decal at the impact point of HitResult, attached to the hit component, recycling an old decal if a budget has been reached */
+	UDecalComponent* SpawnImpactDecal(UMaterialInterface* DecalMaterial, const FVector& DecalSize, const FHitResult& HitResult, EPhysicalSurface SurfaceType);
+
+	/** Returns the number of decal components owned by the subsystem */
+	FORCEINLINE int32 GetNumDecals() const { return Decals.Num(); }
+
+	virtual void Deinitialize() override;
+
+protected:
+
+	/** Every decal component owned by the subsystem */
+	UPROPERTY(Transient)
+	TArray<FSPooledDecal> Decals;
+
+	/** Returns the index in Decals of the decal to reuse for SurfaceType, or INDEX_NONE if a new decal can be created */
+	int32 FindDecalToRecycle(EPhysicalSurface SurfaceType) const;
+};
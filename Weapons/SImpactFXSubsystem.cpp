@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SImpactFXSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "NiagaraComponent.h"
+#include "Sound/SoundBase.h"
+#include "SWeaponStats.h"
+
+static int32 ImpactFXPoolCap = 16;
+FAutoConsoleVariableRef CVARImpactFXPoolCap(
+	TEXT("COOP.ImpactFXPoolCap"),
+	ImpactFXPoolCap,
+	TEXT("The maximum number of pooled components per impact effect"),
+	ECVF_Default);
+
+static float ImpactMergeRadius = 50.f;
+FAutoConsoleVariableRef CVARImpactMergeRadius(
+	TEXT("COOP.ImpactMergeRadius"),
+	ImpactMergeRadius,
+	TEXT("Impacts of the same surface within this size of cell in the same frame play a single effect and sound"),
+	ECVF_Default);
+
+static int32 ImpactMaxEffectsPerFrame = 24;
+FAutoConsoleVariableRef CVARImpactMaxEffectsPerFrame(
+	TEXT("COOP.ImpactMaxEffectsPerFrame"),
+	ImpactMaxEffectsPerFrame,
+	TEXT("The maximum number of impact effects played per frame"),
+	ECVF_Default);
+
+static int32 ImpactMaxSoundsPerFrame = 8;
+FAutoConsoleVariableRef CVARImpactMaxSoundsPerFrame(
+	TEXT("COOP.ImpactMaxSoundsPerFrame"),
+	ImpactMaxSoundsPerFrame,
+	TEXT("The maximum number of impact sounds played per frame"),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdDumpFXPoolStats(
+	TEXT("COOP.FXPoolStats"),
+	TEXT("Logs the hit/miss counters of the impact effect pool and the impact aggregation counters"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		USImpactFXSubsystem* FXSubsystem = World ? World->GetSubsystem<USImpactFXSubsystem>() : nullptr;
+		if (FXSubsystem)
+		{
+			FXSubsystem->DumpStats();
+		}
+	}));
+
+void USImpactFXSubsystem::QueueImpact(EPhysicalSurface SurfaceType, UFXSystemAsset* Effect, USoundBase* Sound, const FVector& Location, const FRotator& Rotation)
+{
+	if ((Effect == nullptr && Sound == nullptr) || GetWorld()->IsNetMode(NM_DedicatedServer))
+		return;
+
+	const float CellSize = FMath::Max(ImpactMergeRadius, 1.f);
+
+	FSImpactClusterKey Key;
+	Key.Effect = Effect;
+	Key.Sound = Sound;
+	Key.SurfaceType = SurfaceType;
+	Key.Cell = FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+
+	NumQueuedImpacts++;
+	INC_DWORD_STAT(STAT_WeaponImpactsQueued);
+
+	FSImpactCluster* Cluster = PendingImpacts.Find(Key);
+	if (Cluster)
+	{
+		Cluster->LocationSum += Location;
+		Cluster->NumImpacts++;
+		NumMergedImpacts++;
+		return;
+	}
+
+	PendingImpacts.Add(Key, { Location, Rotation, 1 });
+}
+
+void USImpactFXSubsystem::Tick(float DeltaTime)
+{
+	FlushImpacts();
+}
+
+ETickableTickType USImpactFXSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool USImpactFXSubsystem::IsTickable() const
+{
+	return PendingImpacts.Num() > 0;
+}
+
+TStatId USImpactFXSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USImpactFXSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* USImpactFXSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void USImpactFXSubsystem::FlushImpacts()
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponFlushImpacts);
+
+	// Play the clusters with the most impacts first so the caps drop the least noticeable impacts
+	PendingImpacts.ValueSort([](const FSImpactCluster& A, const FSImpactCluster& B) { return A.NumImpacts > B.NumImpacts; });
+
+	int32 NumEffects = 0;
+	int32 NumSounds = 0;
+
+	for (const TPair<FSImpactClusterKey, FSImpactCluster>& Pair : PendingImpacts)
+	{
+		const FSImpactCluster& Cluster = Pair.Value;
+		const FVector Location = Cluster.LocationSum / Cluster.NumImpacts;
+
+		// Every doubling of the hits in a cluster makes its effect a quarter larger and louder
+		const float ClusterScale = 1.f + FMath::Min(FMath::Log2((float)Cluster.NumImpacts) * 0.25f, 1.f);
+
+		if (Pair.Key.Effect && NumEffects < ImpactMaxEffectsPerFrame)
+		{
+			SpawnEffectAtLocation(Pair.Key.Effect, Location, Cluster.Rotation, FVector(ClusterScale));
+			NumEffects++;
+		}
+
+		if (Pair.Key.Sound && NumSounds < ImpactMaxSoundsPerFrame)
+		{
+			UGameplayStatics::PlaySoundAtLocation(GetWorld(), Pair.Key.Sound, Location, ClusterScale);
+			NumSounds++;
+		}
+	}
+
+	PendingImpacts.Reset();
+}
+
+UFXSystemComponent* USImpactFXSubsystem::SpawnEffectAtLocation(UFXSystemAsset* Effect, const FVector& Location, const FRotator& Rotation, const FVector& Scale)
+{
+	UWorld* World = GetWorld();
+	if (Effect == nullptr || World == nullptr || World->IsNetMode(NM_DedicatedServer))
+		return nullptr;
+
+	FSFXComponentPool& Pool = Pools.FindOrAdd(Effect);
+
+	INC_DWORD_STAT(STAT_WeaponFXSpawns);
+
+	// Remove components that were destroyed from outside the pool
+	if (Pool.Components.RemoveAllSwap([](UFXSystemComponent* Component) { return Component == nullptr || Component->IsPendingKill(); }) > 0)
+	{
+		UpdatePoolStats();
+	}
+
+	UFXSystemComponent* Component = nullptr;
+	for (UFXSystemComponent* PooledComponent : Pool.Components)
+	{
+		if (!PooledComponent->IsActive())
+		{
+			Component = PooledComponent;
+			break;
+		}
+	}
+
+	if (Component)
+	{
+		PoolHits++;
+	}
+	else if (Pool.Components.Num() < FMath::Max(ImpactFXPoolCap, 1))
+	{
+		PoolMisses++;
+
+		Component = CreateComponent(Effect, Location, Rotation, Scale);
+		if (Component)
+		{
+			Pool.Components.Add(Component);
+			UpdatePoolStats();
+		}
+
+		return Component;
+	}
+	else
+	{
+		// Pool is full, restart the component that has been playing the longest
+		PoolSteals++;
+
+		Pool.NextStolenIndex = Pool.NextStolenIndex % Pool.Components.Num();
+		Component = Pool.Components[Pool.NextStolenIndex++];
+	}
+
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->SetWorldScale3D(Scale);
+	Component->Activate(true);
+
+	return Component;
+}
+
+UFXSystemComponent* USImpactFXSubsystem::CreateComponent(UFXSystemAsset* Effect, const FVector& Location, const FRotator& Rotation, const FVector& Scale)
+{
+	// Components are not auto destroyed, they deactivate when finished and wait in the pool
+	if (UParticleSystem* ParticleSystem = Cast<UParticleSystem>(Effect))
+	{
+		return UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ParticleSystem, Location, Rotation, Scale, false);
+	}
+
+	if (UNiagaraSystem* NiagaraSystem = Cast<UNiagaraSystem>(Effect))
+	{
+		return UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), NiagaraSystem, Location, Rotation, Scale, false);
+	}
+
+	return nullptr;
+}
+
+int32 USImpactFXSubsystem::GetNumPooledComponents() const
+{
+	int32 NumComponents = 0;
+	for (const TPair<UFXSystemAsset*, FSFXComponentPool>& Pool : Pools)
+	{
+		NumComponents += Pool.Value.Components.Num();
+	}
+
+	return NumComponents;
+}
+
+void USImpactFXSubsystem::UpdatePoolStats(bool bRelease)
+{
+#if STATS
+	int32 NumComponents = 0;
+	int64 ComponentMemory = 0;
+
+	if (!bRelease)
+	{
+		for (const TPair<UFXSystemAsset*, FSFXComponentPool>& Pool : Pools)
+		{
+			for (const UFXSystemComponent* Component : Pool.Value.Components)
+			{
+				if (Component)
+				{
+					NumComponents++;
+					ComponentMemory += Component->GetClass()->GetPropertiesSize();
+				}
+			}
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_WeaponLiveImpactFXComponents, NumComponents - ReportedNumComponents);
+	INC_MEMORY_STAT_BY(STAT_WeaponImpactFXComponentMemory, ComponentMemory - ReportedComponentMemory);
+
+	ReportedNumComponents = NumComponents;
+	ReportedComponentMemory = ComponentMemory;
+#endif
+}
+
+void USImpactFXSubsystem::Deinitialize()
+{
+	UpdatePoolStats(true);
+
+	Super::Deinitialize();
+}
+
+void USImpactFXSubsystem::DumpStats() const
+{
+	UE_LOG(LogCoopWeapons, Log, TEXT("Impact FX pool: %d hits, %d misses, %d steals, %d effects, %d components (cap %d per effect)"), PoolHits, PoolMisses, PoolSteals, Pools.Num(), GetNumPooledComponents(), ImpactFXPoolCap);
+	UE_LOG(LogCoopWeapons, Log, TEXT("Impact aggregation: %d impacts queued, %d merged into another impact"), NumQueuedImpacts, NumMergedImpacts);
+}
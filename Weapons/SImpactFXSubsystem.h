@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SImpactFXSubsystem.generated.h"
+
+class UFXSystemAsset;
+class UFXSystemComponent;
+class USoundBase;
+
+/**
+* Impacts of the same effect, sound and surface that landed in the same cell this frame
+*/
+struct FSImpactClusterKey
+{
+	UFXSystemAsset* Effect;
+
+	USoundBase* Sound;
+
+	uint8 SurfaceType;
+
+	/** The location of the impact divided by the merge radius */
+	FIntVector Cell;
+
+	bool operator==(const FSImpactClusterKey& Other) const
+	{
+		return Effect == Other.Effect && Sound == Other.Sound && SurfaceType == Other.SurfaceType && Cell == Other.Cell;
+	}
+
+	friend uint32 GetTypeHash(const FSImpactClusterKey& Key)
+	{
+		uint32 Hash = HashCombine(GetTypeHash(Key.Effect), GetTypeHash(Key.Sound));
+		Hash = HashCombine(Hash, GetTypeHash(Key.Cell));
+		return HashCombine(Hash, Key.SurfaceType);
+	}
+};
+
+/**
+* The merged impacts of a single FSImpactClusterKey
+*/
+struct FSImpactCluster
+{
+	/** Sum of the impact locations, divided by NumImpacts when the cluster is played */
+	FVector LocationSum;
+
+	/** The rotation of the first impact in the cluster */
+	FRotator Rotation;
+
+	/** The number of impacts merged into this cluster */
+	int32 NumImpacts;
+};
+
+/**
+* The pooled components of a single effect
+*/
+USTRUCT()
+struct FSFXComponentPool
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Every component created for the effect, active or not */
+	UPROPERTY(Transient)
+	TArray<UFXSystemComponent*> Components;
+
+	/** The component that is reused next when every component is active and the pool is full */
+	int32 NextStolenIndex;
+
+	FSFXComponentPool()
+		: NextStolenIndex(0)
+	{}
+};
+
+/**
+* World level pool of impact effect components
+* Finished components are reactivated at the new location instead of spawning a new component for every impact
+* Impacts queued during a frame are merged by surface and location, and one effect and sound is played per cluster at the end of the frame
+*/
+UCLASS()
+class COOPHORDE_API USImpactFXSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Queues an impact to be merged with the other impacts this frame, Effect and Sound are played once per cluster */
+	void QueueImpact(EPhysicalSurface SurfaceType, UFXSystemAsset* Effect, USoundBase* Sound, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator);
+
+	/** Plays Effect at Location, reusing a pooled component if possible. Accepts both particle and Niagara systems */
+	UFXSystemComponent* SpawnEffectAtLocation(UFXSystemAsset* Effect, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator, const FVector& Scale = FVector(1.f));
+
+	/** Returns the number of impact effects that reused a pooled component */
+	FORCEINLINE int32 GetPoolHits() const { return PoolHits; }
+
+	/** Returns the number of impact effects that had to create a new component */
+	FORCEINLINE int32 GetPoolMisses() const { return PoolMisses; }
+
+	/** Returns the number of impact effects that restarted a component that was still playing because the pool was full */
+	FORCEINLINE int32 GetPoolSteals() const { return PoolSteals; }
+
+	/** Returns the number of components owned by every pool */
+	int32 GetNumPooledComponents() const;
+
+	/** Logs the pool counters */
+	void DumpStats() const;
+
+	/** Plays one effect and sound for every cluster in PendingImpacts */
+	void FlushImpacts();
+
+	virtual void Deinitialize() override;
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** Impacts queued this frame */
+	TMap<FSImpactClusterKey, FSImpactCluster> PendingImpacts;
+
+	/** The number of impacts queued since the world started, logged by DumpStats() */
+	int32 NumQueuedImpacts;
+
+	/** The number of impacts since the world started that were merged into another impact's effect */
+	int32 NumMergedImpacts;
+
+	/** The number of components added to STAT_WeaponLiveImpactFXComponents by this subsystem */
+	int32 ReportedNumComponents;
+
+	/** The memory added to STAT_WeaponImpactFXComponentMemory by this subsystem */
+	int64 ReportedComponentMemory;
+
+	/** Updates the live component stats after components were added to or removed from the pools, bRelease removes everything this subsystem reported */
+	void UpdatePoolStats(bool bRelease = false);
+
+	/** Pools keyed by the effect they play */
+	UPROPERTY(Transient)
+	TMap<UFXSystemAsset*, FSFXComponentPool> Pools;
+
+	int32 PoolHits;
+
+	int32 PoolMisses;
+
+	int32 PoolSteals;
+
+	/** Creates a new component for Effect */
+	UFXSystemComponent* CreateComponent(UFXSystemAsset* Effect, const FVector& Location, const FRotator& Rotation, const FVector& Scale);
+};
@@ -0,0 +1,481 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SLagCompensationSubsystem.h"
+#include "GameFramework/GameStateBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "SWeaponStats.h"
+
+static int32 LagCompensationEnabled = 1;
+FAutoConsoleVariableRef CVARLagCompensationEnabled(
+	TEXT("COOP.LagCompensation"),
+	LagCompensationEnabled,
+	TEXT("Validate client shots against targets rewound to the time the client fired"),
+	ECVF_Default);
+
+static float LagCompensationMaxRewind = 0.25f;
+FAutoConsoleVariableRef CVARLagCompensationMaxRewind(
+	TEXT("COOP.LagCompensationMaxRewind"),
+	LagCompensationMaxRewind,
+	TEXT("The furthest back in seconds a client shot can be rewound"),
+	ECVF_Default);
+
+/** The number of frames kept in the history ring */
+static const int32 LagCompensationHistoryFrames = 64;
+
+void USLagCompensationSubsystem::RegisterTarget(AActor* Actor, float Radius, float HalfHeight, EPhysicalSurface SurfaceType, USkeletalMeshComponent* HitboxMesh)
+{
+	if (Actor == nullptr || TargetActors.Contains(Actor))
+		return;
+
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop();
+		TargetActors[Slot] = Actor;
+		TargetRadii[Slot] = Radius;
+		TargetHalfHeights[Slot] = FMath::Max(HalfHeight, Radius);
+		TargetSurfaceTypes[Slot] = SurfaceType;
+	}
+	else
+	{
+		Slot = TargetActors.Add(Actor);
+		TargetRadii.Add(Radius);
+		TargetHalfHeights.Add(FMath::Max(HalfHeight, Radius));
+		TargetSurfaceTypes.Add(SurfaceType);
+		TargetMeshes.Add(nullptr);
+		TargetFirstBodies.Add(0);
+		TargetNumBodies.Add(0);
+		TargetBodyCapacities.Add(0);
+	}
+
+	if (Slot >= SlotCapacity)
+	{
+		GrowSlotCapacity(FMath::Max(SlotCapacity * 2, 64));
+	}
+
+	AddBodies(Slot, HitboxMesh);
+
+	// Fill the history with the current pose so rewinding to before registration finds the target where it spawned
+	RecordSlot(NewestFrame, Slot);
+
+	const int32 FirstBody = TargetFirstBodies[Slot];
+	const int32 NumBodies = TargetNumBodies[Slot];
+	for (int32 Frame = 0; Frame < LagCompensationHistoryFrames; Frame++)
+	{
+		if (Frame == NewestFrame)
+			continue;
+
+		FrameLocations[Frame * SlotCapacity + Slot] = FrameLocations[NewestFrame * SlotCapacity + Slot];
+		FrameBoundsRadii[Frame * SlotCapacity + Slot] = FrameBoundsRadii[NewestFrame * SlotCapacity + Slot];
+
+		if (NumBodies > 0)
+		{
+			FMemory::Memcpy(&FrameBodyCentres[Frame * BodyCapacity + FirstBody], &FrameBodyCentres[NewestFrame * BodyCapacity + FirstBody], NumBodies * sizeof(FVector));
+			FMemory::Memcpy(&FrameBodyHalfAxes[Frame * BodyCapacity + FirstBody], &FrameBodyHalfAxes[NewestFrame * BodyCapacity + FirstBody], NumBodies * sizeof(FVector));
+		}
+	}
+}
+
+void USLagCompensationSubsystem::UnregisterTarget(AActor* Actor)
+{
+	const int32 Slot = TargetActors.Find(Actor);
+	if (Slot != INDEX_NONE)
+	{
+		// Hand the mesh back its own visibility tick option
+		if (USkeletalMeshComponent* Mesh = TargetMeshes[Slot])
+		{
+			Mesh->VisibilityBasedAnimTickOption = CastChecked<USkeletalMeshComponent>(Mesh->GetArchetype())->VisibilityBasedAnimTickOption;
+		}
+
+		TargetActors[Slot] = nullptr;
+		TargetMeshes[Slot] = nullptr;
+		TargetNumBodies[Slot] = 0;
+		FreeSlots.Add(Slot);
+	}
+}
+
+void USLagCompensationSubsystem::Deinitialize()
+{
+	DEC_MEMORY_STAT_BY(STAT_WeaponLagCompensationMemory, GetHistoryAllocatedSize());
+
+	Super::Deinitialize();
+}
+
+bool USLagCompensationSubsystem::IsEnabled() const
+{
+	return LagCompensationEnabled != 0 && NumRecordedFrames > 0;
+}
+
+float USLagCompensationSubsystem::ClampRewindTime(float RewindTime) const
+{
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ServerWorldTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->TimeSeconds;
+
+	return FMath::Clamp(RewindTime, ServerWorldTime - LagCompensationMaxRewind, ServerWorldTime);
+}
+
+/** Traces along TraceDirection from Start to End against the capsule around the segment Centre +- HalfAxis, returns true and the distance to the entry point when it is hit */
+static bool TraceCapsule(const FVector& Start, const FVector& End, const FVector& TraceDirection, const FVector& Centre, const FVector& HalfAxis, float Radius, float& OutDistance, FVector& OutImpactNormal)
+{
+	// Closest points between the trace and the capsule's axis
+	FVector ClosestOnTrace;
+	FVector ClosestOnAxis;
+	FMath::SegmentDistToSegmentSafe(Start, End, Centre - HalfAxis, Centre + HalfAxis, ClosestOnTrace, ClosestOnAxis);
+
+	if (FVector::DistSquared(ClosestOnTrace, ClosestOnAxis) > FMath::Square(Radius))
+		return false;
+
+	// Entry point of the trace into the sphere around the closest point on the axis
+	const FVector ToStart = Start - ClosestOnAxis;
+	const float B = ToStart | TraceDirection;
+	const float C = ToStart.SizeSquared() - FMath::Square(Radius);
+	const float Discriminant = FMath::Max(B * B - C, 0.f);
+
+	OutDistance = FMath::Max(-B - FMath::Sqrt(Discriminant), 0.f);
+	OutImpactNormal = (Start + TraceDirection * OutDistance - ClosestOnAxis).GetSafeNormal();
+	return true;
+}
+
+bool USLagCompensationSubsystem::TraceRewound(float RewindTime, const FVector& Start, const FVector& End, const AActor* IgnoredActor, FSRewindHit& OutHit) const
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponLagCompensationRewind);
+
+	if (NumRecordedFrames == 0)
+		return false;
+
+	// Find the two frames either side of RewindTime, walking back from the newest
+	int32 NewerFrame = NewestFrame;
+	int32 OlderFrame = NewestFrame;
+	for (int32 i = 1; i < NumRecordedFrames; i++)
+	{
+		OlderFrame = (NewestFrame - i + LagCompensationHistoryFrames) % LagCompensationHistoryFrames;
+		if (FrameTimes[OlderFrame] <= RewindTime)
+			break;
+
+		NewerFrame = OlderFrame;
+	}
+
+	const float FrameDelta = FrameTimes[NewerFrame] - FrameTimes[OlderFrame];
+	const float Alpha = FrameDelta > KINDA_SMALL_NUMBER ? FMath::Clamp((RewindTime - FrameTimes[OlderFrame]) / FrameDelta, 0.f, 1.f) : 1.f;
+
+	const FVector* OlderLocations = &FrameLocations[OlderFrame * SlotCapacity];
+	const FVector* NewerLocations = &FrameLocations[NewerFrame * SlotCapacity];
+	const float* OlderBoundsRadii = &FrameBoundsRadii[OlderFrame * SlotCapacity];
+	const float* NewerBoundsRadii = &FrameBoundsRadii[NewerFrame * SlotCapacity];
+
+	const FVector TraceDelta = End - Start;
+	const float TraceLength = TraceDelta.Size();
+	if (TraceLength < KINDA_SMALL_NUMBER)
+		return false;
+
+	const FVector TraceDirection = TraceDelta / TraceLength;
+
+	bool bHit = false;
+	OutHit.Distance = TraceLength;
+
+	for (int32 Slot = 0; Slot < TargetActors.Num(); Slot++)
+	{
+		AActor* Actor = TargetActors[Slot];
+		if (Actor == nullptr || Actor == IgnoredActor)
+			continue;
+
+		const FVector Centre = FMath::Lerp(OlderLocations[Slot], NewerLocations[Slot], Alpha);
+		const float BoundsRadius = FMath::Max(OlderBoundsRadii[Slot], NewerBoundsRadii[Slot]);
+
+		// Cheap reject against the sphere holding the capsule and every body
+		const FVector ToCentre = Centre - Start;
+		const float AlongTrace = FMath::Clamp(ToCentre | TraceDirection, 0.f, TraceLength);
+		if ((ToCentre - TraceDirection * AlongTrace).SizeSquared() > FMath::Square(BoundsRadius))
+			continue;
+
+		float HitDistance = 0.f;
+		FVector HitNormal = FVector::ZeroVector;
+
+		const int32 NumBodies = TargetNumBodies[Slot];
+		if (NumBodies == 0)
+		{
+			const float Radius = TargetRadii[Slot];
+			const FVector HalfAxis(0.f, 0.f, TargetHalfHeights[Slot] - Radius);
+
+			if (TraceCapsule(Start, End, TraceDirection, Centre, HalfAxis, Radius, HitDistance, HitNormal) && HitDistance < OutHit.Distance)
+			{
+				bHit = true;
+				OutHit.Actor = Actor;
+				OutHit.Component = Cast<UPrimitiveComponent>(Actor->GetRootComponent());
+				OutHit.Distance = HitDistance;
+				OutHit.ImpactPoint = Start + TraceDirection * HitDistance;
+				OutHit.ImpactNormal = HitNormal;
+				OutHit.BoneName = NAME_None;
+				OutHit.PhysMaterial = nullptr;
+				OutHit.SurfaceType = TargetSurfaceTypes[Slot];
+			}
+			continue;
+		}
+
+		const int32 FirstBody = TargetFirstBodies[Slot];
+		const FVector* OlderCentres = &FrameBodyCentres[OlderFrame * BodyCapacity + FirstBody];
+		const FVector* NewerCentres = &FrameBodyCentres[NewerFrame * BodyCapacity + FirstBody];
+		const FVector* OlderHalfAxes = &FrameBodyHalfAxes[OlderFrame * BodyCapacity + FirstBody];
+		const FVector* NewerHalfAxes = &FrameBodyHalfAxes[NewerFrame * BodyCapacity + FirstBody];
+
+		for (int32 i = 0; i < NumBodies; i++)
+		{
+			// Frames are a tick apart, so lerping the axis is close enough to rotating it
+			const FVector BodyCentre = FMath::Lerp(OlderCentres[i], NewerCentres[i], Alpha);
+			const FVector BodyHalfAxis = FMath::Lerp(OlderHalfAxes[i], NewerHalfAxes[i], Alpha);
+			const FSRewindBody& Body = Bodies[FirstBody + i];
+
+			if (!TraceCapsule(Start, End, TraceDirection, BodyCentre, BodyHalfAxis, Body.Radius, HitDistance, HitNormal) || HitDistance >= OutHit.Distance)
+				continue;
+
+			bHit = true;
+			OutHit.Actor = Actor;
+			OutHit.Component = TargetMeshes[Slot];
+			OutHit.Distance = HitDistance;
+			OutHit.ImpactPoint = Start + TraceDirection * HitDistance;
+			OutHit.ImpactNormal = HitNormal;
+			OutHit.BoneName = Body.BoneName;
+			OutHit.PhysMaterial = Body.PhysMaterial;
+			OutHit.SurfaceType = Body.PhysMaterial ? UPhysicalMaterial::DetermineSurfaceType(Body.PhysMaterial) : TargetSurfaceTypes[Slot];
+		}
+	}
+
+	return bHit;
+}
+
+void USLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	RecordFrame();
+}
+
+ETickableTickType USLagCompensationSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool USLagCompensationSubsystem::IsTickable() const
+{
+	// History is only needed by the server
+	UWorld* World = GetWorld();
+	return World && World->GetNetMode() != NM_Client && TargetActors.Num() > FreeSlots.Num();
+}
+
+TStatId USLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* USLagCompensationSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void USLagCompensationSubsystem::GrowSlotCapacity(int32 NewSlotCapacity)
+{
+	TArray<FVector> NewFrameLocations;
+	NewFrameLocations.SetNumZeroed(LagCompensationHistoryFrames * NewSlotCapacity);
+
+	TArray<float> NewFrameBoundsRadii;
+	NewFrameBoundsRadii.SetNumZeroed(LagCompensationHistoryFrames * NewSlotCapacity);
+
+	for (int32 Frame = 0; Frame < LagCompensationHistoryFrames && SlotCapacity > 0; Frame++)
+	{
+		FMemory::Memcpy(&NewFrameLocations[Frame * NewSlotCapacity], &FrameLocations[Frame * SlotCapacity], SlotCapacity * sizeof(FVector));
+		FMemory::Memcpy(&NewFrameBoundsRadii[Frame * NewSlotCapacity], &FrameBoundsRadii[Frame * SlotCapacity], SlotCapacity * sizeof(float));
+	}
+
+	DEC_MEMORY_STAT_BY(STAT_WeaponLagCompensationMemory, GetHistoryAllocatedSize());
+
+	FrameLocations = MoveTemp(NewFrameLocations);
+	FrameBoundsRadii = MoveTemp(NewFrameBoundsRadii);
+	SlotCapacity = NewSlotCapacity;
+
+	if (FrameTimes.Num() == 0)
+	{
+		FrameTimes.SetNumZeroed(LagCompensationHistoryFrames);
+	}
+
+	INC_MEMORY_STAT_BY(STAT_WeaponLagCompensationMemory, GetHistoryAllocatedSize());
+}
+
+void USLagCompensationSubsystem::GrowBodyCapacity(int32 NewBodyCapacity)
+{
+	TArray<FVector> NewFrameBodyCentres;
+	NewFrameBodyCentres.SetNumZeroed(LagCompensationHistoryFrames * NewBodyCapacity);
+
+	TArray<FVector> NewFrameBodyHalfAxes;
+	NewFrameBodyHalfAxes.SetNumZeroed(LagCompensationHistoryFrames * NewBodyCapacity);
+
+	for (int32 Frame = 0; Frame < LagCompensationHistoryFrames && BodyCapacity > 0; Frame++)
+	{
+		FMemory::Memcpy(&NewFrameBodyCentres[Frame * NewBodyCapacity], &FrameBodyCentres[Frame * BodyCapacity], BodyCapacity * sizeof(FVector));
+		FMemory::Memcpy(&NewFrameBodyHalfAxes[Frame * NewBodyCapacity], &FrameBodyHalfAxes[Frame * BodyCapacity], BodyCapacity * sizeof(FVector));
+	}
+
+	DEC_MEMORY_STAT_BY(STAT_WeaponLagCompensationMemory, GetHistoryAllocatedSize());
+
+	FrameBodyCentres = MoveTemp(NewFrameBodyCentres);
+	FrameBodyHalfAxes = MoveTemp(NewFrameBodyHalfAxes);
+	BodyCapacity = NewBodyCapacity;
+
+	INC_MEMORY_STAT_BY(STAT_WeaponLagCompensationMemory, GetHistoryAllocatedSize());
+}
+
+void USLagCompensationSubsystem::AddBodies(int32 Slot, USkeletalMeshComponent* Mesh)
+{
+	TargetMeshes[Slot] = nullptr;
+	TargetNumBodies[Slot] = 0;
+
+	UPhysicsAsset* PhysicsAsset = Mesh ? Mesh->GetPhysicsAsset() : nullptr;
+	if (PhysicsAsset == nullptr)
+		return;
+
+	// Bone transforms carry the mesh's scale, the radii need it applied here
+	const float Scale = Mesh->GetComponentScale().GetAbsMax();
+
+	TArray<FSRewindBody, TInlineAllocator<32>> NewBodies;
+	for (USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+	{
+		if (BodySetup == nullptr)
+			continue;
+
+		FSRewindBody Body;
+		Body.BoneIndex = Mesh->GetBoneIndex(BodySetup->BoneName);
+		Body.BoneName = BodySetup->BoneName;
+		if (Body.BoneIndex == INDEX_NONE)
+			continue;
+
+		// The same material a live trace against the body returns
+		const FBodyInstance* BodyInstance = Mesh->GetBodyInstance(BodySetup->BoneName);
+		Body.PhysMaterial = BodyInstance ? BodyInstance->GetSimplePhysicalMaterial() : BodySetup->PhysMaterial;
+
+		const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+
+		for (const FKSphereElem& Sphere : AggGeom.SphereElems)
+		{
+			Body.Centre = Sphere.Center;
+			Body.HalfAxis = FVector::ZeroVector;
+			Body.Radius = Sphere.Radius * Scale;
+			NewBodies.Add(Body);
+		}
+
+		for (const FKSphylElem& Sphyl : AggGeom.SphylElems)
+		{
+			Body.Centre = Sphyl.Center;
+			Body.HalfAxis = Sphyl.Rotation.RotateVector(FVector(0.f, 0.f, Sphyl.Length * 0.5f));
+			Body.Radius = Sphyl.Radius * Scale;
+			NewBodies.Add(Body);
+		}
+
+		for (const FKTaperedCapsuleElem& Capsule : AggGeom.TaperedCapsuleElems)
+		{
+			Body.Centre = Capsule.Center;
+			Body.HalfAxis = Capsule.Rotation.RotateVector(FVector(0.f, 0.f, Capsule.Length * 0.5f));
+			Body.Radius = FMath::Max(Capsule.Radius0, Capsule.Radius1) * Scale;
+			NewBodies.Add(Body);
+		}
+
+		// Boxes are recorded as the capsule along their longest side, convex bodies aren't recorded
+		for (const FKBoxElem& Box : AggGeom.BoxElems)
+		{
+			const FVector Extent(Box.X * 0.5f, Box.Y * 0.5f, Box.Z * 0.5f);
+			const int32 LongestAxis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+			const float Radius = FMath::Max(Extent[(LongestAxis + 1) % 3], Extent[(LongestAxis + 2) % 3]);
+
+			FVector HalfAxis = FVector::ZeroVector;
+			HalfAxis[LongestAxis] = FMath::Max(Extent[LongestAxis] - Radius, 0.f);
+
+			Body.Centre = Box.Center;
+			Body.HalfAxis = Box.Rotation.RotateVector(HalfAxis);
+			Body.Radius = Radius * Scale;
+			NewBodies.Add(Body);
+		}
+	}
+
+	if (NewBodies.Num() == 0)
+		return;
+
+	// A slot that needs more bodies than it reserved gets a new block, the old one is left unused
+	if (NewBodies.Num() > TargetBodyCapacities[Slot])
+	{
+		TargetFirstBodies[Slot] = Bodies.Num();
+		TargetBodyCapacities[Slot] = NewBodies.Num();
+		Bodies.AddZeroed(NewBodies.Num());
+
+		if (Bodies.Num() > BodyCapacity)
+		{
+			GrowBodyCapacity(FMath::Max3(BodyCapacity * 2, Bodies.Num(), 256));
+		}
+	}
+
+	const int32 FirstBody = TargetFirstBodies[Slot];
+	for (int32 i = 0; i < NewBodies.Num(); i++)
+	{
+		Bodies[FirstBody + i] = NewBodies[i];
+	}
+
+	TargetMeshes[Slot] = Mesh;
+	TargetNumBodies[Slot] = NewBodies.Num();
+
+	// Bones are only refreshed when rendered by default, which a dedicated server never does
+	// The option is owned here while the mesh is recorded, the significance subsystem leaves it alone on the server
+	Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+}
+
+void USLagCompensationSubsystem::RecordSlot(int32 Frame, int32 Slot)
+{
+	const FVector Location = TargetActors[Slot]->GetActorLocation();
+	float BoundsRadius = TargetHalfHeights[Slot];
+
+	const USkeletalMeshComponent* Mesh = TargetMeshes[Slot];
+	const int32 NumBodies = TargetNumBodies[Slot];
+	if (Mesh && NumBodies > 0)
+	{
+		const int32 FirstBody = TargetFirstBodies[Slot];
+		FVector* Centres = &FrameBodyCentres[Frame * BodyCapacity + FirstBody];
+		FVector* HalfAxes = &FrameBodyHalfAxes[Frame * BodyCapacity + FirstBody];
+
+		for (int32 i = 0; i < NumBodies; i++)
+		{
+			const FSRewindBody& Body = Bodies[FirstBody + i];
+			const FTransform BoneTransform = Mesh->GetBoneTransform(Body.BoneIndex);
+
+			Centres[i] = BoneTransform.TransformPosition(Body.Centre);
+			HalfAxes[i] = BoneTransform.TransformVector(Body.HalfAxis);
+
+			BoundsRadius = FMath::Max(BoundsRadius, FVector::Dist(Centres[i], Location) + HalfAxes[i].Size() + Body.Radius);
+		}
+	}
+
+	FrameLocations[Frame * SlotCapacity + Slot] = Location;
+	FrameBoundsRadii[Frame * SlotCapacity + Slot] = BoundsRadius;
+}
+
+void USLagCompensationSubsystem::RecordFrame()
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponLagCompensationRecord);
+
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+
+	NewestFrame = (NewestFrame + 1) % LagCompensationHistoryFrames;
+	NumRecordedFrames = FMath::Min(NumRecordedFrames + 1, LagCompensationHistoryFrames);
+	FrameTimes[NewestFrame] = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->TimeSeconds;
+
+	for (int32 Slot = 0; Slot < TargetActors.Num(); Slot++)
+	{
+		if (TargetActors[Slot])
+		{
+			RecordSlot(NewestFrame, Slot);
+		}
+	}
+}
+
+SIZE_T USLagCompensationSubsystem::GetHistoryAllocatedSize() const
+{
+	return FrameTimes.GetAllocatedSize() + FrameLocations.GetAllocatedSize() + FrameBoundsRadii.GetAllocatedSize()
+		+ FrameBodyCentres.GetAllocatedSize() + FrameBodyHalfAxes.GetAllocatedSize();
+}
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SLagCompensationSubsystem.generated.h"
+
+class USkeletalMeshComponent;
+class UPhysicalMaterial;
+
+/**
+* The closest target hit by a rewound trace
+*/
+struct FSRewindHit
+{
+	AActor* Actor;
+
+	/** The target's skeletal mesh when one of its bodies was hit, otherwise its root component */
+	UPrimitiveComponent* Component;
+
+	FVector ImpactPoint;
+
+	FVector ImpactNormal;
+
+	/** Distance from the start of the trace to the ImpactPoint */
+	float Distance;
+
+	/** The bone of the body hit, NAME_None for targets recorded as a single capsule */
+	FName BoneName;
+
+	/** The physical material of the body hit, null for targets recorded as a single capsule */
+	UPhysicalMaterial* PhysMaterial;
+
+	/** The surface type of the body's physical material, or the surface type registered for the target */
+	uint8 SurfaceType;
+};
+
+/**
+* A body of a target's physics asset, recorded as a capsule around its bone
+*/
+struct FSRewindBody
+{
+	/** Index of the bone in the target's mesh */
+	int32 BoneIndex;
+
+	FName BoneName;
+
+	/** Centre of the capsule in bone space */
+	FVector Centre;
+
+	/** Half of the capsule's axis in bone space, zero for a sphere */
+	FVector HalfAxis;
+
+	/** Capsule radius, scaled by the mesh */
+	float Radius;
+
+	/** Kept alive by the physics asset of the mesh */
+	UPhysicalMaterial* PhysMaterial;
+};
+
+/**
+* Server side history of the hitboxes of every lag compensated target
+* Every tick the location of each target, and the pose of each body of its physics asset, is recorded into a ring of frames, stored as struct of arrays so a rewind only touches what it needs
+* Shots from remote clients are validated against the bodies interpolated to the time the client fired, so they hit the same bones and surfaces as a live trace would
+* Targets without a physics asset are recorded as an upright capsule
+*/
+UCLASS()
+class COOPHORDE_API USLagCompensationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	* Starts recording Actor, a HalfHeight equal to Radius records a sphere
+	* The capsule rejects traces that can't hit the target, when HitboxMesh has a physics asset its bodies are what is hit
+	*/
+	void RegisterTarget(AActor* Actor, float Radius, float HalfHeight, EPhysicalSurface SurfaceType, USkeletalMeshComponent* HitboxMesh = nullptr);
+
+	/** Stops recording Actor */
+	void UnregisterTarget(AActor* Actor);
+
+	/** Returns every registered target, may contain nulls */
+	FORCEINLINE const TArray<AActor*>& GetTargetActors() const { return TargetActors; }
+
+	virtual void Deinitialize() override;
+
+	/** Whether shots should be lag compensated */
+	bool IsEnabled() const;
+
+	/** Clamps a client fire time to the history that is kept */
+	float ClampRewindTime(float RewindTime) const;
+
+	/** Traces from Start to End against every target as it was at RewindTime, returns true and fills OutHit with the closest target hit */
+	bool TraceRewound(float RewindTime, const FVector& Start, const FVector& End, const AActor* IgnoredActor, FSRewindHit& OutHit) const;
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+
+	/** The registered targets indexed by slot, null for free slots */
+	UPROPERTY(Transient)
+	TArray<AActor*> TargetActors;
+
+	/** Capsule radius of each slot */
+	TArray<float> TargetRadii;
+
+	/** Capsule half height of each slot */
+	TArray<float> TargetHalfHeights;
+
+	/** Surface type of each slot */
+	TArray<uint8> TargetSurfaceTypes;
+
+	/** The mesh whose bodies are recorded for each slot, null for slots recorded as a capsule */
+	UPROPERTY(Transient)
+	TArray<USkeletalMeshComponent*> TargetMeshes;
+
+	/** Index in Bodies of the first body of each slot */
+	TArray<int32> TargetFirstBodies;
+
+	/** The number of bodies of each slot */
+	TArray<int32> TargetNumBodies;
+
+	/** The number of bodies reserved for each slot, kept when the slot is freed so the next target can reuse them */
+	TArray<int32> TargetBodyCapacities;
+
+	/** The bodies of every slot, each slot's bodies are contiguous */
+	TArray<FSRewindBody> Bodies;
+
+	/** Free slots to reuse before adding new ones */
+	TArray<int32> FreeSlots;
+
+	/** The server time of each recorded frame */
+	TArray<float> FrameTimes;
+
+	/** Recorded capsule centres, indexed by Frame * SlotCapacity + Slot */
+	TArray<FVector> FrameLocations;
+
+	/** Radius around the recorded capsule centre that holds every body, indexed by Frame * SlotCapacity + Slot */
+	TArray<float> FrameBoundsRadii;
+
+	/** Recorded body centres, indexed by Frame * BodyCapacity + Body */
+	TArray<FVector> FrameBodyCentres;
+
+	/** Recorded half axes of the bodies, indexed by Frame * BodyCapacity + Body */
+	TArray<FVector> FrameBodyHalfAxes;
+
+	/** The number of slots each frame has room for */
+	int32 SlotCapacity;
+
+	/** The number of bodies each frame has room for */
+	int32 BodyCapacity;
+
+	/** The index in FrameTimes of the newest frame */
+	int32 NewestFrame;
+
+	/** The number of frames that have been recorded, up to the ring size */
+	int32 NumRecordedFrames;
+
+	/** Resizes every frame to hold NewSlotCapacity slots, keeping recorded locations */
+	void GrowSlotCapacity(int32 NewSlotCapacity);
+
+	/** Resizes every frame to hold NewBodyCapacity bodies, keeping recorded poses */
+	void GrowBodyCapacity(int32 NewBodyCapacity);
+
+	/** Adds the bodies of Mesh's physics asset to Slot, reusing the bodies reserved for the slot when there are enough */
+	void AddBodies(int32 Slot, USkeletalMeshComponent* Mesh);
+
+	/** Records the current location and pose of the target in Slot into Frame */
+	void RecordSlot(int32 Frame, int32 Slot);
+
+	/** Records the current location and pose of every target into a new frame */
+	void RecordFrame();
+
+	/** The memory used by the recorded frames */
+	SIZE_T GetHistoryAllocatedSize() const;
+};
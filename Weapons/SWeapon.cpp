@@ -1,341 +1,878 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "SWeapon.h"
-#include "SCharacterBase.h"
-#include "SCharacterPlayer.h"
-#include "Components/SphereComponent.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "DrawDebugHelpers.h"
-#include "Kismet/GameplayStatics.h"
-#include "Particles/ParticleSystemComponent.h"
-#include "TimerManager.h"
-#include "Sound/SoundBase.h"
-#include "Net/UnrealNetwork.h"
-#include "../CoopHorde.h"
-
-// Sets default values
-ASWeapon::ASWeapon()
-{
-	Mesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Mesh"));
-	SetRootComponent(Mesh);
-
-	CollisionSphere = CreateDefaultSubobject<USphereComponent>(TEXT("GroundCollisionSphere"));
-	CollisionSphere->SetupAttachment(GetRootComponent());
-	CollisionSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	CollisionSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	CollisionSphere->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
-
-	MuzzleSocketName = "MuzzleFlashSocket";	
-
-	BaseDamage = 20.f;
-	CurrentDamage = BaseDamage;
-	RateOfFire = 600.f;
-	AIDamageScaler = .3f;
-
-	SetReplicates(true);
-
-	NetUpdateFrequency = 66.f;
-	MinNetUpdateFrequency = 33.f;
-
-	// Crosshair values
-	FireCrosshairSpreadAdditive = 20.f;
-	MaxFireCrosshairSpreadAdditive = 60.f;
-	CrosshairMinDistanceToCentre = 50.f;
-	CrosshairMaxDistanceToCentre = 100.f;
-	CrosshairMinDistanceToCentreADS = 15.f;
-	CrosshairMaxDistanceToCentreADS = 45.f;
-
-	MaxAmmo = 999;
-	CurrentAmmo = MaxAmmo;
-	MaxAmmoPerClip = 30;
-	CurrentAmmoInClip = MaxAmmoPerClip;
-
-	KillImpluseAmount = 50000.f;
-
-	WeaponState = EWeaponState::EWS_Idle;
-
-	GunHandSocket = "GunHandIK";
-		
-	bIsOnGround = false;
-
-	SetReplicateMovement(true);
-}
-
-void ASWeapon::ResetWeaponState()
-{
-	GetWorldTimerManager().ClearTimer(TimerHandle_ReloadAnimation);
-	bPendingReload = false;
-	bTryToFire = false;
-	DetermineWeaponState();
-}
-
-void ASWeapon::BeginPlay()
-{
-	Super::BeginPlay();
-	
-	TimeBetweenShots = 60 / RateOfFire;
-
-	CollisionSphere->OnComponentBeginOverlap.AddDynamic(this, &ASWeapon::OnCollisionOverlapBegin);
-	CollisionSphere->OnComponentEndOverlap.AddDynamic(this, &ASWeapon::OnCollisionOverlapEnd);
-
-	SetupAttachmentToOwner();
-}
-
-void ASWeapon::HandleFiring()
-{
-	DetermineWeaponState();
-
-	if (CanFire())
-	{
-		Fire();
-		CurrentAmmoInClip--;
-	}
-	else
-	{
-		TryReload();
-	}
-}
-
-void ASWeapon::Fire()
-{	
-}
-
-void ASWeapon::ServerFire_Implementation()
-{
-	Fire();
-}
-
-bool ASWeapon::ServerFire_Validate()
-{
-	return true;
-}
-
-void ASWeapon::SetOwningPawn(ASCharacterBase* Pawn)
-{
-	OwningPawn = Pawn;
-}
-
-void ASWeapon::StartFire()
-{
-	bTryToFire = true;
-	float FirstDelay = FMath::Max(LastFireTime + TimeBetweenShots - GetWorld()->TimeSeconds, 0.f);
-	GetWorldTimerManager().SetTimer(TimeHandle_TimeBetweenShots, this, &ASWeapon::HandleFiring, TimeBetweenShots, true, FirstDelay);
-}
-
-void ASWeapon::StopFire()
-{
-	bTryToFire = false;
-	GetWorldTimerManager().ClearTimer(TimeHandle_TimeBetweenShots);
-
-	DetermineWeaponState();
-}
-
-USkeletalMeshComponent* ASWeapon::GetMesh()
-{
-	return Mesh;
-}
-
-void ASWeapon::PlayFireEffect()
-{
-	if (MuzzleEffect)
-	{
-		UGameplayStatics::SpawnEmitterAttached(MuzzleEffect, Mesh, MuzzleSocketName);
-	}
-
-	APawn* MyOwner = Cast<APawn>(GetOwner());
-	if (MyOwner)
-	{
-		APlayerController* PC = Cast<APlayerController>(MyOwner->GetController());
-
-		if (PC)
-		{
-			PC->ClientPlayCameraShake(FireCamShake);
-		}
-	}
-
-	if (FireSound)
-	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
-	}
-
-	// Recoil Animation
-	if (OwningPawn->IsAimingDownSights())
-	{
-		if (RecoilAnimationADS)
-		{
-			OwningPawn->PlayAnimMontage(RecoilAnimationADS);
-		}
-	}
-	else
-	{
-		if (RecoilAnimationFromHip)
-		{
-			OwningPawn->PlayAnimMontage(RecoilAnimationFromHip);
-		}
-	}
-}
-
-void ASWeapon::DetermineWeaponState()
-{
-	if (bPendingReload && CanReload())
-	{
-		WeaponState = EWeaponState::EWS_Reloading;
-	}
-	else if (bTryToFire && CanFire())
-	{
-		WeaponState = EWeaponState::EWS_Firing;
-	}
-	else
-	{
-		WeaponState = EWeaponState::EWS_Idle;
-	}
-}
-
-bool ASWeapon::CanFire()
-{
-	return CurrentAmmoInClip > 0 
-		&& !bPendingReload 
-		&& !OwningPawn->IsEquipping()
-		&& OwningPawn->IsWeaponEquipped(this);
-}
-
-void ASWeapon::TryReload()
-{
-	if (!bPendingReload && CanReload())
-	{
-		bPendingReload = true;
-		
-		PlayReloadAnimation();
-
-		DetermineWeaponState();
-	}
-}
-
-void ASWeapon::Reload()
-{
-	if (CurrentAmmo > 0 && CurrentAmmoInClip < MaxAmmoPerClip)
-	{
-		const int32 TempCurrentAmmo = CurrentAmmo;
-		// Remove reloaded ammo from current ammo
-		CurrentAmmo = FMath::Max(CurrentAmmo - (MaxAmmoPerClip - CurrentAmmoInClip), 0);
-		// Reload current clip
-		CurrentAmmoInClip = FMath::Min(MaxAmmoPerClip, CurrentAmmoInClip + TempCurrentAmmo);
-	}
-
-	bPendingReload = false;
-	OwningPawn->SetHandIKAlpha(1.f);
-
-	DetermineWeaponState();
-}
-
-bool ASWeapon::CanReload()
-{
-	return CurrentAmmo > 0 
-		&& CurrentAmmoInClip < MaxAmmoPerClip
-		&& !OwningPawn->IsEquipping()
-		&& OwningPawn->IsWeaponEquipped(this);
-}
-
-void ASWeapon::PlayReloadAnimation()
-{
-	if (HasAuthority())
-	{
-		NetMulticastPlayReloadAnimation();
-	}
-	else
-	{
-		ServerPlayReloadAnimation();
-	}
-}
-
-void ASWeapon::AddToCurrentAmmo(int32 AmountToAdd)
-{
- 	if (OwningPawn->IsLocallyControlled())
-	{
-		CurrentAmmo = FMath::Min(CurrentAmmo + AmountToAdd, MaxAmmo);
-	}
-	else
-	{
-		ClientAddToCurrentAmmo(AmountToAdd);
-	}
-}
-
-void ASWeapon::DropWeapon()
-{	
-	// Put weapon on ground
-	FHitResult Hit;
-	FVector TraceEnd = GetActorLocation() + FVector(0.f, 0.f, -300.f);
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
-	QueryParams.AddIgnoredActor(GetOwner());
-	GetWorld()->LineTraceSingleByChannel(Hit, GetActorLocation(), TraceEnd, ECollisionChannel::ECC_Camera, QueryParams);
-
-	if (Hit.bBlockingHit)
-	{
-		SetActorLocation(Hit.Location);
-		SetActorRotation(FRotator(90.f, GetActorRotation().Yaw, 0.f));
-	}
-
-	SetIsOnGround(true);
-	CollisionSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	SetLifeSpan(120.f);
-}
-
-void ASWeapon::PickupWeapon(ASCharacterBase* PawnOwner)
-{
-	SetOwningPawn(PawnOwner);
-	SetOwner(PawnOwner);
-	SetupAttachmentToOwner();
-	ResetDamage();
-	SetLifeSpan(0);
-}
-
-void ASWeapon::ResetDamage()	
-{	
-	CurrentDamage = OwningPawn->IsPlayerControlled() ? BaseDamage : BaseDamage * AIDamageScaler;
-}
-
-void ASWeapon::ClientAddToCurrentAmmo_Implementation(int32 AmountToAdd)
-{
-	AddToCurrentAmmo(AmountToAdd);
-}
-
-void ASWeapon::ServerPlayReloadAnimation_Implementation()
-{
-	NetMulticastPlayReloadAnimation();
-}
-
-void ASWeapon::NetMulticastPlayReloadAnimation_Implementation()
-{
-	OwningPawn->SetHandIKAlpha(0.f);
-
-	float AnimDuration = OwningPawn->PlayAnimMontage(ReloadAnimation);
-	// Reload weapon after animation has finished
-	GetWorldTimerManager().SetTimer(TimerHandle_ReloadAnimation, this, &ASWeapon::Reload, AnimDuration - 0.2f);
-}
-
-void ASWeapon::OnCollisionOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
-{
-	ASCharacterPlayer* Player = Cast<ASCharacterPlayer>(OtherActor);
-	if (Player)
-	{
-		Player->SetOverlappingWeaponPickup(this);
-	}
-}
-
-void ASWeapon::OnCollisionOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
-{
-	ASCharacterPlayer* Player = Cast<ASCharacterPlayer>(OtherActor);
-	if (Player)
-	{
-		Player->RemoveOverlappingWeaponPickup(this);
-	}
-}
-
-void ASWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
-{
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-
-	DOREPLIFETIME(ASWeapon, OwningPawn);
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWeapon.h"
+#include "SCharacterBase.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "DrawDebugHelpers.h"
+#include "GameFramework/GameStateBase.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "TimerManager.h"
+#include "Sound/SoundBase.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "SLagCompensationSubsystem.h"
+#include "SGroundItemSubsystem.h"
+#include "SWeaponPoolSubsystem.h"
+#include "SCosmeticEventSubsystem.h"
+#include "SWeaponDefinition.h"
+#include "SWeaponStats.h"
+#include "../CoopHorde.h"
+
+/** Shots due in one frame past this are dropped, so a hitch doesn't dump a burst of shots */
+static const int32 MaxScheduledShotsPerFrame = 8;
+
+/** The most shots sent in, and applied from, a single ServerFireInputs() */
+static const int32 MaxFireInputsPerRPC = 16;
+
+/** How often unacknowledged shots are resent when no new shot has been fired */
+static const float FireInputResendInterval = 0.05f;
+
+/** Shots the server lets a client fire faster than its rate of fire, so shots bunched up by network jitter aren't dropped */
+static const float MaxFireRateBurstShots = 3.f;
+
+/** The furthest a client's fire time can be behind the server's clock, older times are treated as this old */
+static const float MaxClientFireTimeLag = 1.f;
+
+/** The furthest a client's fire time can be from the server's clock before its shots are dropped, allowing for resent shots and clock drift */
+static const float MaxClientFireTimeError = 5.f;
+
+/** The furthest a shot's eye location is moved from where the server has the owner, to where the client fired from */
+static const float MaxShotOriginOffset = 100.f;
+
+/** The furthest a client's eye location can be from where the server has the owner before its shots are dropped */
+static const float MaxShotOriginError = 500.f;
+
+#if WITH_EDITORONLY_DATA
+/** The name of the definition PostLoad() generates inside a weapon Blueprint's package */
+static const FName MigratedDefinitionName = TEXT("MigratedWeaponDefinition");
+#endif
+
+/** Whether shot sequence A comes after B, allowing for wrap around */
+static bool IsNewerShotSequence(uint16 A, uint16 B)
+{
+	return (int16)(A - B) > 0;
+}
+
+FSFireInput::FSFireInput(uint16 InShotSequence, float InClientFireTime, const FVector& InEyeLocation, const FRotator& AimRotation)
+	: ShotSequence(InShotSequence)
+	, ClientFireTime(InClientFireTime)
+	, EyeLocation(InEyeLocation)
+	, AimYaw(FRotator::CompressAxisToShort(AimRotation.Yaw))
+	, AimPitch(FRotator::CompressAxisToShort(AimRotation.Pitch))
+{
+}
+
+FRotator FSFireInput::GetAimRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(AimPitch), FRotator::DecompressAxisFromShort(AimYaw), 0.f);
+}
+
+bool FSFireInput::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << ShotSequence;
+	Ar << ClientFireTime;
+	Ar << AimYaw;
+	Ar << AimPitch;
+
+	bOutSuccess = true;
+	EyeLocation.NetSerialize(Ar, Map, bOutSuccess);
+	return true;
+}
+
+bool FSWeaponPackedState::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedAmmo = CurrentAmmo;
+	uint32 PackedAmmoInClip = CurrentAmmoInClip;
+	Ar.SerializeIntPacked(PackedAmmo);
+	Ar.SerializeIntPacked(PackedAmmoInClip);
+
+	uint32 PackedWeaponState = (uint32)WeaponState;
+	Ar.SerializeInt(PackedWeaponState, (uint32)EWeaponState::EWS_Reloading + 1);
+
+	uint8 PackedPendingReload = bPendingReload ? 1 : 0;
+	Ar.SerializeBits(&PackedPendingReload, 1);
+
+	if (Ar.IsLoading())
+	{
+		CurrentAmmo = PackedAmmo;
+		CurrentAmmoInClip = PackedAmmoInClip;
+		WeaponState = (EWeaponState)PackedWeaponState;
+		bPendingReload = PackedPendingReload != 0;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+// Sets default values
+ASWeapon::ASWeapon()
+{
+	// Only ticks while trying to fire, after the owner has moved this frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	Mesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Mesh"));
+	SetRootComponent(Mesh);
+
+	MuzzleSocketName = "MuzzleFlashSocket";	
+
+	const USWeaponDefinition* DefaultDefinition = GetDefault<USWeaponDefinition>();
+	CurrentDamage = DefaultDefinition->BaseDamage;
+
+	SetReplicates(true);
+
+	// Idle weapons have nothing to send, and the push model only sends properties marked dirty since the last update
+	NetUpdateFrequency = 10.f;
+	MinNetUpdateFrequency = 2.f;
+
+	CurrentAmmo = DefaultDefinition->MaxAmmo;
+	CurrentAmmoInClip = DefaultDefinition->MaxAmmoPerClip;
+
+	WeaponState = EWeaponState::EWS_Idle;
+
+	PackedState.CurrentAmmo = CurrentAmmo;
+	PackedState.CurrentAmmoInClip = CurrentAmmoInClip;
+
+	GunHandSocket = "GunHandIK";
+
+	bIsPooled = false;
+
+	ShotSequence = 0;
+	ShotRewindTime = -1.f;
+
+	LastFireInputSendTime = 0.f;
+	LastAckedShotSequence = MAX_uint16;
+	LastAppliedFireTime = 0.f;
+	FireRateBudget = MaxFireRateBurstShots;
+	LastFireRateBudgetTime = 0.f;
+
+	bPackedStateSkipped = false;
+
+	NextShotTime = 0.f;
+	LastScheduleTime = 0.f;
+
+	SetReplicateMovement(true);
+
+#if WITH_EDITORONLY_DATA
+	// The values the settings had before they moved to the definition, Blueprints only saved the ones they changed
+	BaseDamage_DEPRECATED = DefaultDefinition->BaseDamage;
+	RateOfFire_DEPRECATED = DefaultDefinition->RateOfFire;
+	AIDamageScaler_DEPRECATED = DefaultDefinition->AIDamageScaler;
+	KillImpluseAmount_DEPRECATED = DefaultDefinition->KillImpulseAmount;
+	MaxAmmo_DEPRECATED = DefaultDefinition->MaxAmmo;
+	MaxAmmoPerClip_DEPRECATED = DefaultDefinition->MaxAmmoPerClip;
+	FireCrosshairSpreadAdditive_DEPRECATED = DefaultDefinition->FireCrosshairSpreadAdditive;
+	MaxFireCrosshairSpreadAdditive_DEPRECATED = DefaultDefinition->MaxFireCrosshairSpreadAdditive;
+	CrosshairMinDistanceToCentre_DEPRECATED = DefaultDefinition->CrosshairMinDistanceToCentre;
+	CrosshairMaxDistanceToCentre_DEPRECATED = DefaultDefinition->CrosshairMaxDistanceToCentre;
+	CrosshairMinDistanceToCentreADS_DEPRECATED = DefaultDefinition->CrosshairMinDistanceToCentreADS;
+	CrosshairMaxDistanceToCentreADS_DEPRECATED = DefaultDefinition->CrosshairMaxDistanceToCentreADS;
+#endif
+}
+
+#if WITH_EDITORONLY_DATA
+void ASWeapon::PostLoad()
+{
+	Super::PostLoad();
+
+	if (!HasAnyFlags(RF_ClassDefaultObject) || GetClass()->ClassGeneratedBy == nullptr)
+		return;
+
+	// A child Blueprint inherits its parent's generated definition, but may have changed the settings it was made from
+	const bool bInheritedMigratedDefinition = Definition && Definition->GetFName() == MigratedDefinitionName && Definition->GetOutermost() != GetOutermost();
+	if (Definition && !bInheritedMigratedDefinition)
+		return;
+
+	UPackage* Package = GetOutermost();
+	USWeaponDefinition* NewDefinition = FindObject<USWeaponDefinition>(Package, *MigratedDefinitionName.ToString());
+	if (NewDefinition == nullptr)
+	{
+		NewDefinition = NewObject<USWeaponDefinition>(Package, MigratedDefinitionName, RF_Public | RF_Transactional);
+	}
+
+	CopyDeprecatedSettings(NewDefinition);
+	Definition = NewDefinition;
+
+	UE_LOG(LogCoopWeapons, Log, TEXT("%s had no weapon definition, generated one from its deprecated settings. Resave it to keep it"), *GetClass()->GetName());
+}
+
+void ASWeapon::CopyDeprecatedSettings(USWeaponDefinition* NewDefinition) const
+{
+	NewDefinition->WeaponName = WeaponName_DEPRECATED;
+	NewDefinition->DamageType = DamageType_DEPRECATED;
+	NewDefinition->BaseDamage = BaseDamage_DEPRECATED;
+	NewDefinition->AIDamageScaler = AIDamageScaler_DEPRECATED;
+	NewDefinition->RateOfFire = RateOfFire_DEPRECATED;
+	NewDefinition->KillImpulseAmount = KillImpluseAmount_DEPRECATED;
+	NewDefinition->MaxAmmo = MaxAmmo_DEPRECATED;
+	NewDefinition->MaxAmmoPerClip = MaxAmmoPerClip_DEPRECATED;
+	NewDefinition->FireCrosshairSpreadAdditive = FireCrosshairSpreadAdditive_DEPRECATED;
+	NewDefinition->MaxFireCrosshairSpreadAdditive = MaxFireCrosshairSpreadAdditive_DEPRECATED;
+	NewDefinition->CrosshairMinDistanceToCentre = CrosshairMinDistanceToCentre_DEPRECATED;
+	NewDefinition->CrosshairMaxDistanceToCentre = CrosshairMaxDistanceToCentre_DEPRECATED;
+	NewDefinition->CrosshairMinDistanceToCentreADS = CrosshairMinDistanceToCentreADS_DEPRECATED;
+	NewDefinition->CrosshairMaxDistanceToCentreADS = CrosshairMaxDistanceToCentreADS_DEPRECATED;
+	NewDefinition->ReloadAnimation = ReloadAnimation_DEPRECATED;
+	NewDefinition->MuzzleEffect = MuzzleEffect_DEPRECATED;
+	NewDefinition->DefaultImpactEffect = DefaultImpactEffect_DEPRECATED;
+	NewDefinition->FleshImpactEffect = FleshImpactEffect_DEPRECATED;
+	NewDefinition->MetalImpactEffect = MetalImpactEffect_DEPRECATED;
+	NewDefinition->BulletHitDecal = BulletHitDecal_DEPRECATED;
+	NewDefinition->FireSound = FireSound_DEPRECATED;
+	NewDefinition->ImpactSoundFlesh = ImpactSoundFlesh_DEPRECATED;
+	NewDefinition->ImpactSoundMetal = ImpactSoundMetal_DEPRECATED;
+	NewDefinition->ImpactSoundDefault = ImpactSoundDefault_DEPRECATED;
+	NewDefinition->FireCamShake = FireCamShake_DEPRECATED.Get();
+}
+#endif
+
+void ASWeapon::ResetWeaponState()
+{
+	bPendingReload = false;
+	bTryToFire = false;
+	SetActorTickEnabled(false);
+	DetermineWeaponState();
+}
+
+void ASWeapon::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ensureMsgf(Definition, TEXT("%s has no weapon definition set, it uses the default stats without any animations or effects"), *GetClass()->GetName());
+	
+	const USWeaponDefinition* WeaponDefinition = GetDefinition();
+	TimeBetweenShots = 60 / WeaponDefinition->RateOfFire;
+	CurrentDamage = WeaponDefinition->BaseDamage;
+
+	// The first weapon of a kind to begin play loads what it needs, the rest share it
+	WeaponDefinition->LoadAssets(GetNetMode() != NM_DedicatedServer);
+
+	if (HasAuthority())
+	{
+		UpdatePackedState();
+	}
+
+	// Weapons placed in the level as pickups become ground items straight away
+	if (HasAuthority() && IsNetStartupActor() && GetOwner() == nullptr)
+	{
+		DropWeapon();
+		return;
+	}
+
+	// Weapons prewarmed into the pool have no owner yet
+	if (GetOwner())
+	{
+		SetupAttachmentToOwner();
+	}
+}
+
+void ASWeapon::LifeSpanExpired()
+{
+	USWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<USWeaponPoolSubsystem>();
+	if (WeaponPool && HasAuthority())
+	{
+		WeaponPool->ReleaseWeapon(this);
+	}
+	else
+	{
+		Super::LifeSpanExpired();
+	}
+}
+
+void ASWeapon::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bTryToFire)
+	{
+		ScheduleShots();
+	}
+
+	// Keep resending until the server acknowledges, a lost packet is covered by the next one
+	if (PendingFireInputs.Num() > 0 && GetWorld()->TimeSeconds - LastFireInputSendTime >= FireInputResendInterval)
+	{
+		SendFireInputs();
+	}
+
+	if (!bTryToFire && PendingFireInputs.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void ASWeapon::ScheduleShots()
+{
+	const float Now = GetWorld()->TimeSeconds;
+
+	FVector EyeLocation = FVector::ZeroVector;
+	FRotator EyeRotation = FRotator::ZeroRotator;
+	if (GetOwner())
+	{
+		GetOwner()->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+	}
+
+	const float FrameTime = Now - LastScheduleTime;
+	const FQuat LastEyeQuat = LastScheduleEyeRotation.Quaternion();
+	const FQuat EyeQuat = EyeRotation.Quaternion();
+
+	TArray<FSWeaponShot, TInlineAllocator<MaxScheduledShotsPerFrame>> Shots;
+	while (NextShotTime <= Now && Shots.Num() < MaxScheduledShotsPerFrame)
+	{
+		// Place the shot between the last frame and this one, as if the weapon had been fired at exactly the right time
+		const float Alpha = FrameTime > KINDA_SMALL_NUMBER ? FMath::Clamp((NextShotTime - LastScheduleTime) / FrameTime, 0.f, 1.f) : 1.f;
+
+		FSWeaponShot& Shot = Shots.AddDefaulted_GetRef();
+		Shot.Time = NextShotTime;
+		Shot.EyeLocation = FMath::Lerp(LastScheduleEyeLocation, EyeLocation, Alpha);
+		Shot.EyeRotation = FQuat::Slerp(LastEyeQuat, EyeQuat, Alpha).Rotator();
+
+		NextShotTime += TimeBetweenShots;
+	}
+
+	if (NextShotTime <= Now)
+	{
+		NextShotTime = Now + TimeBetweenShots;
+	}
+
+	LastScheduleTime = Now;
+	LastScheduleEyeLocation = EyeLocation;
+	LastScheduleEyeRotation = EyeRotation;
+
+	if (Shots.Num() > 0)
+	{
+		HandleFiring(Shots);
+	}
+}
+
+void ASWeapon::HandleFiring(TArrayView<const FSWeaponShot> Shots)
+{
+	SCOPE_WEAPON_CYCLE_COUNTER(STAT_WeaponHandleFiring);
+
+	for (const FSWeaponShot& Shot : Shots)
+	{
+		DetermineWeaponState();
+
+		if (!CanFire())
+		{
+			TryReload();
+			break;
+		}
+
+		Fire(Shot);
+		CurrentAmmoInClip--;
+	}
+
+	if (HasAuthority())
+	{
+		UpdatePackedState();
+	}
+
+	// Every shot of the frame goes out in one packet
+	if (PendingFireInputs.Num() > 0)
+	{
+		SendFireInputs();
+	}
+}
+
+void ASWeapon::Fire(const FSWeaponShot& Shot)
+{	
+}
+
+FSWeaponShot ASWeapon::MakeShotNow() const
+{
+	FSWeaponShot Shot;
+	Shot.Time = GetWorld()->TimeSeconds;
+
+	if (GetOwner())
+	{
+		GetOwner()->GetActorEyesViewPoint(Shot.EyeLocation, Shot.EyeRotation);
+	}
+
+	return Shot;
+}
+
+void ASWeapon::QueueFireInput(uint16 InShotSequence, float ClientFireTime, const FVector& EyeLocation, const FRotator& AimRotation)
+{
+	PendingFireInputs.Emplace(InShotSequence, ClientFireTime, EyeLocation, AimRotation);
+
+	// A client that hasn't heard back for this many shots has bigger problems than a missing shot
+	if (PendingFireInputs.Num() > MaxFireInputsPerRPC)
+	{
+		PendingFireInputs.RemoveAt(0, PendingFireInputs.Num() - MaxFireInputsPerRPC, false);
+	}
+
+	SetActorTickEnabled(true);
+}
+
+void ASWeapon::SendFireInputs()
+{
+	LastFireInputSendTime = GetWorld()->TimeSeconds;
+	ServerFireInputs(PendingFireInputs);
+}
+
+void ASWeapon::ServerFireInputs_Implementation(const TArray<FSFireInput>& FireInputs)
+{
+	INC_DWORD_STAT(STAT_WeaponFireRPCs);
+
+	USLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<USLagCompensationSubsystem>();
+	const bool bLagCompensate = LagCompensation && LagCompensation->IsEnabled();
+
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ServerWorldTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->TimeSeconds;
+
+	// The rate of fire is enforced by the server's clock, the client's fire times only order the shots
+	FireRateBudget = FMath::Min(FireRateBudget + (ServerWorldTime - LastFireRateBudgetTime) / TimeBetweenShots, MaxFireRateBurstShots);
+	LastFireRateBudgetTime = ServerWorldTime;
+
+	for (const FSFireInput& FireInput : FireInputs)
+	{
+		// Redundant copy of a shot that was already applied
+		if (!IsNewerShotSequence(FireInput.ShotSequence, LastAckedShotSequence))
+			continue;
+
+		LastAckedShotSequence = FireInput.ShotSequence;
+
+		// The server's own ammo, reload and equip state decide whether the shot could be fired
+		if (OwningPawn == nullptr || !CanFire())
+			continue;
+
+		// Out of shots for the time that has passed on the server
+		if (FireRateBudget < 1.f)
+			continue;
+
+		// Too far from the server's clock to be a resent shot or clock drift
+		if (FMath::Abs(FireInput.ClientFireTime - ServerWorldTime) > MaxClientFireTimeError)
+			continue;
+
+		// Too far from the server's copy of the owner, after a teleport, respawn or large correction
+		FSWeaponShot Shot = MakeShotNow();
+		const FVector ShotOriginOffset = FVector(FireInput.EyeLocation) - Shot.EyeLocation;
+		if (ShotOriginOffset.SizeSquared() > FMath::Square(MaxShotOriginError))
+			continue;
+
+		// A client can't claim to fire in the future, or further in the past than it could have
+		const float ClientFireTime = FMath::Clamp(FireInput.ClientFireTime, ServerWorldTime - MaxClientFireTimeLag, ServerWorldTime);
+
+		// Shots closer together than the weapon can fire are dropped, leaving room for the client's clock to drift
+		if (ClientFireTime - LastAppliedFireTime < TimeBetweenShots * 0.5f)
+			continue;
+
+		FireRateBudget -= 1.f;
+		LastAppliedFireTime = ClientFireTime;
+
+		// The client saw its targets where they were when it fired, so the shot is validated against them there
+		ShotSequence = FireInput.ShotSequence;
+		ShotRewindTime = bLagCompensate ? LagCompensation->ClampRewindTime(ClientFireTime) : -1.f;
+
+		// The client fired from where it saw itself, as far as the server's copy of its movement allows
+		Shot.EyeLocation += ShotOriginOffset.GetClampedToMaxSize(MaxShotOriginOffset);
+		Shot.EyeRotation = FireInput.GetAimRotation();
+		Shot.ClientFireTime = ClientFireTime;
+		Fire(Shot);
+
+		// The owner spends its own ammo when it fires, the server keeps its copy in step for everyone else
+		CurrentAmmoInClip--;
+	}
+
+	ShotRewindTime = -1.f;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(ASWeapon, LastAckedShotSequence, this);
+	UpdatePackedState();
+}
+
+bool ASWeapon::ServerFireInputs_Validate(const TArray<FSFireInput>& FireInputs)
+{
+	if (FireInputs.Num() > MaxFireInputsPerRPC)
+		return false;
+
+	for (const FSFireInput& FireInput : FireInputs)
+	{
+		if (FMath::IsNaN(FireInput.ClientFireTime))
+			return false;
+	}
+
+	return true;
+}
+
+void ASWeapon::OnRep_LastAckedShotSequence()
+{
+	PendingFireInputs.RemoveAll([this](const FSFireInput& FireInput) { return !IsNewerShotSequence(FireInput.ShotSequence, LastAckedShotSequence); });
+
+	// A weapon picked up from someone else carries on from their shots
+	if (PendingFireInputs.Num() == 0 && !IsNewerShotSequence(ShotSequence, LastAckedShotSequence))
+	{
+		ShotSequence = LastAckedShotSequence + 1;
+	}
+
+	// Every shot has been applied, so the server's state has caught up with the owner
+	if (PendingFireInputs.Num() == 0)
+	{
+		ApplyPackedState();
+	}
+}
+
+void ASWeapon::UpdatePackedState()
+{
+	FSWeaponPackedState NewPackedState;
+	NewPackedState.CurrentAmmo = CurrentAmmo;
+	NewPackedState.CurrentAmmoInClip = CurrentAmmoInClip;
+	NewPackedState.WeaponState = WeaponState;
+	NewPackedState.bPendingReload = bPendingReload;
+
+	if (NewPackedState == PackedState)
+		return;
+
+	PackedState = NewPackedState;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ASWeapon, PackedState, this);
+}
+
+void ASWeapon::OnRep_PackedState()
+{
+	bPackedStateSkipped = true;
+	ApplyPackedState();
+}
+
+void ASWeapon::ApplyPackedState()
+{
+	if (!bPackedStateSkipped)
+		return;
+
+	// The owner is ahead of the server while it has shots in flight or is reloading, it is corrected once they have been applied
+	if (OwningPawn && OwningPawn->IsLocallyControlled() && (bTryToFire || bPendingReload || PendingFireInputs.Num() > 0))
+		return;
+
+	bPackedStateSkipped = false;
+
+	CurrentAmmo = PackedState.CurrentAmmo;
+	CurrentAmmoInClip = PackedState.CurrentAmmoInClip;
+	WeaponState = PackedState.WeaponState;
+	bPendingReload = PackedState.bPendingReload;
+}
+
+void ASWeapon::SetOwningPawn(ASCharacterBase* Pawn)
+{
+	OwningPawn = Pawn;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ASWeapon, OwningPawn, this);
+}
+
+void ASWeapon::StartFire()
+{
+	bTryToFire = true;
+
+	const float Now = GetWorld()->TimeSeconds;
+	NextShotTime = FMath::Max(LastFireTime + TimeBetweenShots, Now);
+
+	LastScheduleTime = Now;
+	if (GetOwner())
+	{
+		GetOwner()->GetActorEyesViewPoint(LastScheduleEyeLocation, LastScheduleEyeRotation);
+	}
+
+	SetActorTickEnabled(true);
+
+	// Fire straight away if the weapon is ready
+	ScheduleShots();
+}
+
+void ASWeapon::StopFire()
+{
+	bTryToFire = false;
+
+	// Keeps ticking to resend shots the server hasn't acknowledged yet
+	SetActorTickEnabled(PendingFireInputs.Num() > 0);
+
+	DetermineWeaponState();
+	ApplyPackedState();
+}
+
+USkeletalMeshComponent* ASWeapon::GetMesh()
+{
+	return Mesh;
+}
+
+void ASWeapon::PlayFireEffect()
+{
+	USCosmeticEventSubsystem* Cosmetics = GetWorld()->GetSubsystem<USCosmeticEventSubsystem>();
+	if (Cosmetics == nullptr)
+		return;
+
+	Cosmetics->QueueFire(this);
+
+	// Only shakes the camera of a local player, the server no longer sends a client RPC for every shot
+	APawn* MyOwner = Cast<APawn>(GetOwner());
+	if (MyOwner)
+	{
+		Cosmetics->QueueCameraShake(Cast<APlayerController>(MyOwner->GetController()), GetDefinition()->FireCamShake.Get());
+	}
+}
+
+void ASWeapon::PlayQueuedFireEffect(int32 NumShots, bool bPlayVisuals)
+{
+	// Effects that haven't finished loading yet are skipped
+	const USWeaponDefinition* WeaponDefinition = GetDefinition();
+
+	USoundBase* FireSound = WeaponDefinition->FireSound.Get();
+	if (FireSound)
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+	}
+
+	if (!bPlayVisuals)
+		return;
+
+	UParticleSystem* MuzzleEffect = WeaponDefinition->MuzzleEffect.Get();
+	if (MuzzleEffect)
+	{
+		if (MuzzleEffectComponent)
+		{
+			MuzzleEffectComponent->Activate(true);
+		}
+		else
+		{
+			MuzzleEffectComponent = UGameplayStatics::SpawnEmitterAttached(MuzzleEffect, Mesh, MuzzleSocketName, FVector::ZeroVector, FRotator::ZeroRotator, EAttachLocation::SnapToTarget, false);
+		}
+	}
+
+	// Procedural recoil, every shot kicks the owner's recoil spring
+	if (OwningPawn)
+	{
+		const float ImpulseScale = OwningPawn->IsAimingDownSights() ? WeaponDefinition->RecoilImpulseScaleADS : 1.f;
+		for (int32 i = 0; i < NumShots; i++)
+		{
+			const float Yaw = FMath::FRandRange(-WeaponDefinition->RecoilImpulseYaw, WeaponDefinition->RecoilImpulseYaw);
+			OwningPawn->AddRecoilImpulse(FRotator(WeaponDefinition->RecoilImpulsePitch, Yaw, 0.f) * ImpulseScale);
+		}
+	}
+}
+
+void ASWeapon::PlayTracerEffects(FVector TraceEnd)
+{
+}
+
+void ASWeapon::DetermineWeaponState()
+{
+	if (bPendingReload && CanReload())
+	{
+		WeaponState = EWeaponState::EWS_Reloading;
+	}
+	else if (bTryToFire && CanFire())
+	{
+		WeaponState = EWeaponState::EWS_Firing;
+	}
+	else
+	{
+		WeaponState = EWeaponState::EWS_Idle;
+	}
+
+	if (HasAuthority())
+	{
+		UpdatePackedState();
+	}
+}
+
+bool ASWeapon::CanFire()
+{
+	return CurrentAmmoInClip > 0 
+		&& !bPendingReload 
+		&& !OwningPawn->IsEquipping()
+		&& OwningPawn->IsWeaponEquipped(this);
+}
+
+void ASWeapon::TryReload()
+{
+	if (!bPendingReload && CanReload())
+	{
+		bPendingReload = true;
+		
+		PlayReloadAnimation();
+
+		DetermineWeaponState();
+	}
+}
+
+void ASWeapon::Reload()
+{
+	const int32 MaxAmmoPerClip = GetDefinition()->MaxAmmoPerClip;
+	if (CurrentAmmo > 0 && CurrentAmmoInClip < MaxAmmoPerClip)
+	{
+		const int32 TempCurrentAmmo = CurrentAmmo;
+		// Remove reloaded ammo from current ammo
+		CurrentAmmo = FMath::Max(CurrentAmmo - (MaxAmmoPerClip - CurrentAmmoInClip), 0);
+		// Reload current clip
+		CurrentAmmoInClip = FMath::Min(MaxAmmoPerClip, CurrentAmmoInClip + TempCurrentAmmo);
+	}
+
+	bPendingReload = false;
+
+	DetermineWeaponState();
+
+	// A state sent while the server was still reloading is replaced by the one it sends when it finishes
+	if (!PackedState.bPendingReload)
+	{
+		ApplyPackedState();
+	}
+}
+
+bool ASWeapon::CanReload()
+{
+	const USWeaponDefinition* WeaponDefinition = GetDefinition();
+
+	// The reload montage is still streaming in if it is set but not loaded
+	const bool bReloadAnimationReady = WeaponDefinition->ReloadAnimation.IsNull() || WeaponDefinition->ReloadAnimation.IsValid();
+
+	return CurrentAmmo > 0 
+		&& CurrentAmmoInClip < WeaponDefinition->MaxAmmoPerClip
+		&& bReloadAnimationReady
+		&& !OwningPawn->IsEquipping()
+		&& OwningPawn->IsWeaponEquipped(this);
+}
+
+void ASWeapon::PlayReloadAnimation()
+{
+	if (HasAuthority())
+	{
+		// CanReload() waits for the montage to load, the reload is timed off its length
+		OwningPawn->GetTimedActionComponent()->StartAction(ESTimedActionType::Reload, GetDefinition()->ReloadAnimation.Get());
+	}
+	else
+	{
+		ServerTryReload();
+	}
+}
+
+void ASWeapon::ServerTryReload_Implementation()
+{
+	TryReload();
+}
+
+void ASWeapon::AddToCurrentAmmo(int32 AmountToAdd)
+{
+	// The owner adds it straight away, the server's count replicates to everyone through PackedState
+	if (HasAuthority() || OwningPawn->IsLocallyControlled())
+	{
+		CurrentAmmo = FMath::Min(CurrentAmmo + AmountToAdd, GetDefinition()->MaxAmmo);
+	}
+
+	if (HasAuthority())
+	{
+		UpdatePackedState();
+	}
+}
+
+void ASWeapon::DropWeapon()
+{	
+	// Put weapon on ground
+	FHitResult Hit;
+	FVector TraceEnd = GetActorLocation() + FVector(0.f, 0.f, -300.f);
+	FCollisionQueryParams QueryParams;
+	QueryParams.AddIgnoredActor(this);
+	QueryParams.AddIgnoredActor(GetOwner());
+	GetWorld()->LineTraceSingleByChannel(Hit, GetActorLocation(), TraceEnd, ECollisionChannel::ECC_Camera, QueryParams);
+
+	// The weapon lives on as a ground item record until it is picked up again
+	USGroundItemSubsystem* GroundItems = GetWorld()->GetSubsystem<USGroundItemSubsystem>();
+	if (GroundItems)
+	{
+		GroundItems->AddItem(GetClass(), CurrentAmmo, CurrentAmmoInClip, Hit.bBlockingHit ? Hit.Location : GetActorLocation(), GetActorRotation().Yaw);
+	}
+
+	USWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<USWeaponPoolSubsystem>();
+	if (WeaponPool)
+	{
+		WeaponPool->ReleaseWeapon(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void ASWeapon::SetAmmo(int32 NewCurrentAmmo, int32 NewCurrentAmmoInClip)
+{
+	const USWeaponDefinition* WeaponDefinition = GetDefinition();
+	CurrentAmmo = FMath::Clamp(NewCurrentAmmo, 0, WeaponDefinition->MaxAmmo);
+	CurrentAmmoInClip = FMath::Clamp(NewCurrentAmmoInClip, 0, WeaponDefinition->MaxAmmoPerClip);
+
+	if (HasAuthority())
+	{
+		UpdatePackedState();
+	}
+}
+
+void ASWeapon::ResetAmmo()
+{
+	const ASWeapon* Defaults = GetClass()->GetDefaultObject<ASWeapon>();
+	SetAmmo(Defaults->CurrentAmmo, Defaults->CurrentAmmoInClip);
+}
+
+void ASWeapon::ResetForPool()
+{
+	ResetWeaponState();
+	ResetAmmo();
+
+	PendingFireInputs.Reset();
+
+	// The next owner's shots start a new sequence, so the server doesn't drop them as already applied
+	ShotSequence = 0;
+	LastAckedShotSequence = MAX_uint16;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ASWeapon, LastAckedShotSequence, this);
+
+	// The next owner's shots must not be rate limited or scheduled against the last owner's
+	LastAppliedFireTime = 0.f;
+	FireRateBudget = MaxFireRateBurstShots;
+	LastFireRateBudgetTime = 0.f;
+	LastFireTime = 0.f;
+	NextShotTime = 0.f;
+
+	if (MuzzleEffectComponent)
+	{
+		MuzzleEffectComponent->Deactivate();
+	}
+
+	SetOwningPawn(nullptr);
+}
+
+void ASWeapon::PickupWeapon(ASCharacterBase* PawnOwner)
+{
+	SetOwningPawn(PawnOwner);
+	SetOwner(PawnOwner);
+	SetupAttachmentToOwner();
+	ResetDamage();
+}
+
+void ASWeapon::ResetDamage()	
+{	
+	const USWeaponDefinition* WeaponDefinition = GetDefinition();
+	CurrentDamage = OwningPawn->IsPlayerControlled() ? WeaponDefinition->BaseDamage : WeaponDefinition->BaseDamage * WeaponDefinition->AIDamageScaler;
+}
+
+float ASWeapon::GetKillImpulseAmount() const
+{
+	return GetDefinition()->KillImpulseAmount;
+}
+
+FName ASWeapon::GetWeaponName() const
+{
+	return GetDefinition()->WeaponName;
+}
+
+const USWeaponDefinition* ASWeapon::GetDefinition() const
+{
+	return Definition ? Definition : GetDefault<USWeaponDefinition>();
+}
+
+void ASWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ASWeapon, OwningPawn, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ASWeapon, PackedState, Params);
+
+	Params.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ASWeapon, LastAckedShotSequence, Params);
+}
@@ -1,305 +1,491 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "SWeapon.generated.h"
-
-// OnDamageDealth Event
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_SixParams(FOnDamageDealtSignature, AActor*, DamagedActor, float, Health, float, HealthDelta, const class UDamageType*, DamageType, class AController*, InstigatedBy, AActor*, DamageCauser);
-// OnWeaponFired Event
-DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnWeaponFiredSignature);
-
-class USkeletalMeshComponent;
-class USoundBase;
-class ASCharacterBase;
-class UNiagaraSystem;
-class USphereComponent;
-
-/**
-* Used to determine what the weapon is currently doing
-*/
-UENUM()
-enum class EWeaponState : uint8
-{
-	EWS_Idle,
-	EWS_Firing,
-	EWS_Reloading
-};
-
-UCLASS()
-class COOPHORDE_API ASWeapon : public AActor
-{
-	GENERATED_BODY()
-	
-public:	
-	// Sets default values for this actor's properties
-	ASWeapon();
-
-	/** The DamageType this weapon will cause */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
-	TSubclassOf<UDamageType> DamageType;
-
-	/** Event that is broadcast when the weapon is fired */
-	UPROPERTY(BlueprintAssignable, Category = Events)
-	FOnWeaponFiredSignature OnWeaponFired;
-
-protected:
-
-	/** The weapons mesh */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
-	USkeletalMeshComponent* Mesh;
-
-	/** Used when the weapon is on the ground to overlap for the  */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Components)
-	USphereComponent* CollisionSphere;
-
-	/** The pawn that has this weapon equipped */
-	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
-	ASCharacterBase* OwningPawn;
-
-	/** What the weapon is currently doing */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
-	EWeaponState WeaponState;
-
-	/** The name of the muzzle socket on the Mesh */
-	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = Weapon)
-	FName MuzzleSocketName;
-
-	/** The effect used when the weapon is fired */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects)
-	UParticleSystem* MuzzleEffect;
-	
-	/** The default impact effect used when the weapon is fired at something */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects)
-	UParticleSystem* DefaultImpactEffect;
-	
-	/** The default impact effect used when the weapon is fired at the flesh Physical Surface */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects)
-	UParticleSystem* FleshImpactEffect;
-
-	/** The default impact effect used when the weapon is fired at the metal Physical Surface */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects)
-	UNiagaraSystem* MetalImpactEffect;
-
-	/** Decal spawned when weapon fires at objects */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects)
-	UMaterialInterface* BulletHitDecal;
-
-	/** The sound that is play everytime the weapon is shot */
-	UPROPERTY(EditDefaultsOnly, Category = Sound)
-	USoundBase* FireSound;
-
-	/** The sound that is played when the weapon's shot hits something */
-	UPROPERTY(EditDefaultsOnly, Category = Sound)
-	USoundBase* ImpactSoundFlesh;
-	UPROPERTY(EditDefaultsOnly, Category = Sound)
-	USoundBase* ImpactSoundMetal;
-	UPROPERTY(EditDefaultsOnly, Category = Sound)
-	USoundBase* ImpactSoundDefault;
-
-	/** Camera shake used when the weapon is fired */
-	UPROPERTY(EditDefaultsOnly, Category = Weapon)
-	TSubclassOf<UCameraShake> FireCamShake;
-
-	/** The base damage each shot of the weapon does */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = Weapon)
-	float BaseDamage;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
-	float CurrentDamage;
-
-	/** This handles the timing between each shot */
-	FTimerHandle TimeHandle_TimeBetweenShots;
-
-	/** The time the last shot was fired */
-	float LastFireTime;
-
-	/** RPM - Bullets per minute fired */
-	UPROPERTY(EditDefaultsOnly, Category = Weapon)
-	float RateOfFire;
-
-	/** Derived from RateOfFire */
-	float TimeBetweenShots;
-	
-	/** The socket the characters left hand will be attached to */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
-	FName GunHandSocket;
-
-	/** The amount of crosshair spread added when the weapon is fired */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
-	float FireCrosshairSpreadAdditive;
-
-	/** The maximum amount of crosshair spread added when the weapon is fired */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
-	float MaxFireCrosshairSpreadAdditive;
-
-	/** The minimum distance from centre of the screen to the crosshair */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
-	float CrosshairMinDistanceToCentre;
-
-	/** The maximum distance from centre of the screen to the crosshair */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
-	float CrosshairMaxDistanceToCentre;
-
-	/** The minimum distance from centre of the screen to the crosshair when aiming down sights */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
-	float CrosshairMinDistanceToCentreADS;
-
-	/** The maximum distance from centre of the screen to the crosshair when aiming down sights */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
-	float CrosshairMaxDistanceToCentreADS;
-
-	/** The current ammo no in the clip */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
-	int32 CurrentAmmo;
-
-	/** The current ammo in the clip */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
-	int32 CurrentAmmoInClip;
-
-	/** The maximum ammo per clip */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
-	int32 MaxAmmoPerClip;
-
-	FTimerHandle TimerHandle_ReloadAnimation;
-
-	/** The maximum ammo for this weapon */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
-	int32 MaxAmmo;
-
-	/** Used to try and fire the weapon */
-	UPROPERTY(BlueprintReadOnly)
-	bool bTryToFire;
-
-	/** Used to try and reload the weapon */
-	bool bPendingReload;
-
-	/** Animation played when reloading */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation)
-	UAnimMontage* ReloadAnimation;
-
-	/** The amount of impulse added to an actor when killed by this weapon */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
-	float KillImpluseAmount;
-
-	/** Whether or not the weapon is on the ground or attached to a character */
-	bool bIsOnGround;
-
-	/** The name of the weapon, used in game */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
-	FName WeaponName;
-
-	/** The amount the weapon damage is scaled by when held by an AI */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon, meta = (ClampMin = 0.01f, ClampMax = 1.f))
-	float AIDamageScaler;
-
-	/** The animation played on the owner when the weapon is fired from the hip */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon, meta = (ClampMin = 0.01f, ClampMax = 1.f))
-	UAnimMontage* RecoilAnimationFromHip;
-
-	/** The animation played on the owner when the weapon is fired ADS */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon, meta = (ClampMin = 0.01f, ClampMax = 1.f))
-	UAnimMontage* RecoilAnimationADS;
-
-public:
-	
-	/** Sets OwningPawn */
-	void SetOwningPawn(ASCharacterBase* Pawn);
-
-	/** Calls Fire() on weapon if TimeBetweenShots has passed since the last shot */
-	virtual void StartFire();
-
-	/** Clears TimeHandle_TimeBetweenShots */
-	virtual void StopFire();
-
-	/** Returns Mesh */
-	USkeletalMeshComponent* GetMesh();
-
-	/** Tries to reload if possible */
-	void TryReload();
-
-	/** Resets the weapons states/values */
-	void ResetWeaponState();
-
-	/** Plays reload animation selected for this weapon */
-	void PlayReloadAnimation();
-	UFUNCTION(Server, Reliable)
-	void ServerPlayReloadAnimation();
-	UFUNCTION(NetMulticast, Reliable)
-	void NetMulticastPlayReloadAnimation();
-
-	UFUNCTION(BlueprintCallable)
-	void AddToCurrentAmmo(int32 AmountToAdd);
-
-	/** Detaches the weapon from the owner, places it on the ground and readys it for being pickable */
-	void DropWeapon();
-
-	/** Attaches the overlapping weapon to the character */
-	void PickupWeapon(ASCharacterBase* PawnOwner);
-
-	UFUNCTION(BlueprintCallable)
-	void ResetDamage();
-
-	UFUNCTION(BlueprintImplementableEvent)
-	void SetupAttachmentToOwner();
-
-	FORCEINLINE FName GetGunHandSocket() { return GunHandSocket; }
-
-	FORCEINLINE EWeaponState GetWeaponState() { return WeaponState; }
-	
-	FORCEINLINE float GetKillImpulseAmount() { return KillImpluseAmount; }
-
-	UFUNCTION(BlueprintCallable, BlueprintPure)
-	FORCEINLINE USkeletalMeshComponent* GetSkeletalMeshComponent() { return Mesh; }
-		
-	FORCEINLINE bool GetIsOnGround() { return bIsOnGround; }
-		
-	FORCEINLINE void SetIsOnGround(bool NewIsOnGround) { bIsOnGround = NewIsOnGround; }
-
-	FORCEINLINE FName GetWeaponName() { return WeaponName; }
-
-protected:
-
-	virtual void BeginPlay() override;
-
-	/** Tries to fire weapon if possible */
-	void HandleFiring();
-
-	/** Fires the weapon using a line trace, and plays the corresponding impact effect depending on the Physics Surface hit */
-	virtual void Fire();
-
-	/** Calls Fire() on the server */
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerFire();
-
-	/** Plays the selecetd effects when the weapon is fired */
-	void PlayFireEffect();
-	
-	/** Removes the fire spread additive from the Crosshair */
-	UFUNCTION(BlueprintImplementableEvent)
-	void ResetWeaponFireSpread();
-
-	/** Determines what EWeaponState the weapon is currently in and updates WeaponState */
-	void DetermineWeaponState();
-
-	/** Whether or not the weapon can be fired */
-	bool CanFire();
-
-	/** Reloads the current clip to it's max and takes the ammo away from the CurrentAmmo */
-	void Reload();
-
-	/** Whether or not the weapon can be reloaded */
-	bool CanReload();
-
-	/** Calls AddToCurrentAmmo on the client */
-	UFUNCTION(Client, Reliable)
-	void ClientAddToCurrentAmmo(int32 AmountToAdd);
-
-	UFUNCTION()
-	void OnCollisionOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
-	UFUNCTION()
-	void OnCollisionOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Containers/ArrayView.h"
+#include "SWeapon.generated.h"
+
+// OnDamageDealth Event
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_SixParams(FOnDamageDealtSignature, AActor*, DamagedActor, float, Health, float, HealthDelta, const class UDamageType*, DamageType, class AController*, InstigatedBy, AActor*, DamageCauser);
+// OnWeaponFired Event
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnWeaponFiredSignature);
+
+class USkeletalMeshComponent;
+class ASCharacterBase;
+class UParticleSystemComponent;
+class USWeaponDefinition;
+class UParticleSystem;
+class UNiagaraSystem;
+class UMaterialInterface;
+class USoundBase;
+class UCameraShake;
+class UAnimMontage;
+
+/**
+* A single shot from the fire scheduler, which can fall anywhere between the previous frame and this one
+*/
+struct FSWeaponShot
+{
+	/** The world time the shot was fired at */
+	float Time;
+
+	/** The owner's eye location interpolated to Time */
+	FVector EyeLocation;
+
+	/** The owner's eye rotation interpolated to Time */
+	FRotator EyeRotation;
+
+	/** The server world time the owning client fired the shot at, negative for shots fired on this machine */
+	float ClientFireTime;
+
+	FSWeaponShot()
+		: Time(0.f)
+		, EyeLocation(FVector::ZeroVector)
+		, EyeRotation(FRotator::ZeroRotator)
+		, ClientFireTime(-1.f)
+	{}
+};
+
+/**
+* A shot fired by a client, sent to the server until it has been acknowledged
+*/
+USTRUCT()
+struct FSFireInput
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The shot sequence the client fired the shot with */
+	UPROPERTY()
+	uint16 ShotSequence;
+
+	/** The server world time the client fired the shot at */
+	UPROPERTY()
+	float ClientFireTime;
+
+	/** The client's eye location the shot was fired from */
+	UPROPERTY()
+	FVector_NetQuantize10 EyeLocation;
+
+	/** Compressed yaw of the client's aim */
+	UPROPERTY()
+	uint16 AimYaw;
+
+	/** Compressed pitch of the client's aim */
+	UPROPERTY()
+	uint16 AimPitch;
+
+	FSFireInput()
+		: ShotSequence(0)
+		, ClientFireTime(0.f)
+		, EyeLocation(ForceInitToZero)
+		, AimYaw(0)
+		, AimPitch(0)
+	{}
+
+	FSFireInput(uint16 InShotSequence, float InClientFireTime, const FVector& InEyeLocation, const FRotator& AimRotation);
+
+	/** Returns the decompressed aim */
+	FRotator GetAimRotation() const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSFireInput> : public TStructOpsTypeTraitsBase2<FSFireInput>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+* Used to determine what the weapon is currently doing
+*/
+UENUM()
+enum class EWeaponState : uint8
+{
+	EWS_Idle,
+	EWS_Firing,
+	EWS_Reloading
+};
+
+/**
+* The server's ammo and state for a weapon, packed into a few bytes and only sent when it changes
+*/
+USTRUCT()
+struct FSWeaponPackedState
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Ammo held outside the clip */
+	UPROPERTY()
+	int32 CurrentAmmo;
+
+	/** Ammo in the clip */
+	UPROPERTY()
+	int32 CurrentAmmoInClip;
+
+	/** What the weapon is doing */
+	UPROPERTY()
+	EWeaponState WeaponState;
+
+	/** Whether a reload has been started and not finished */
+	UPROPERTY()
+	bool bPendingReload;
+
+	FSWeaponPackedState()
+		: CurrentAmmo(0)
+		, CurrentAmmoInClip(0)
+		, WeaponState(EWeaponState::EWS_Idle)
+		, bPendingReload(false)
+	{}
+
+	bool operator==(const FSWeaponPackedState& Other) const
+	{
+		return CurrentAmmo == Other.CurrentAmmo
+			&& CurrentAmmoInClip == Other.CurrentAmmoInClip
+			&& WeaponState == Other.WeaponState
+			&& bPendingReload == Other.bPendingReload;
+	}
+
+	bool operator!=(const FSWeaponPackedState& Other) const { return !(*this == Other); }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSWeaponPackedState> : public TStructOpsTypeTraitsBase2<FSWeaponPackedState>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+UCLASS()
+class COOPHORDE_API ASWeapon : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	ASWeapon();
+
+	/** Event that is broadcast when the weapon is fired */
+	UPROPERTY(BlueprintAssignable, Category = Events)
+	FOnWeaponFiredSignature OnWeaponFired;
+
+protected:
+
+	/** The weapons mesh */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	USkeletalMeshComponent* Mesh;
+
+	/** The stats, animations and effects shared by every instance of this weapon */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	USWeaponDefinition* Definition;
+
+#if WITH_EDITORONLY_DATA
+	// Settings from before they moved to the definition, copied into a generated one by PostLoad()
+	UPROPERTY()
+	TSubclassOf<UDamageType> DamageType_DEPRECATED;
+	UPROPERTY()
+	UParticleSystem* MuzzleEffect_DEPRECATED;
+	UPROPERTY()
+	UParticleSystem* DefaultImpactEffect_DEPRECATED;
+	UPROPERTY()
+	UParticleSystem* FleshImpactEffect_DEPRECATED;
+	UPROPERTY()
+	UNiagaraSystem* MetalImpactEffect_DEPRECATED;
+	UPROPERTY()
+	UMaterialInterface* BulletHitDecal_DEPRECATED;
+	UPROPERTY()
+	USoundBase* FireSound_DEPRECATED;
+	UPROPERTY()
+	USoundBase* ImpactSoundFlesh_DEPRECATED;
+	UPROPERTY()
+	USoundBase* ImpactSoundMetal_DEPRECATED;
+	UPROPERTY()
+	USoundBase* ImpactSoundDefault_DEPRECATED;
+	UPROPERTY()
+	TSubclassOf<UCameraShake> FireCamShake_DEPRECATED;
+	UPROPERTY()
+	float BaseDamage_DEPRECATED;
+	UPROPERTY()
+	float RateOfFire_DEPRECATED;
+	UPROPERTY()
+	float FireCrosshairSpreadAdditive_DEPRECATED;
+	UPROPERTY()
+	float MaxFireCrosshairSpreadAdditive_DEPRECATED;
+	UPROPERTY()
+	float CrosshairMinDistanceToCentre_DEPRECATED;
+	UPROPERTY()
+	float CrosshairMaxDistanceToCentre_DEPRECATED;
+	UPROPERTY()
+	float CrosshairMinDistanceToCentreADS_DEPRECATED;
+	UPROPERTY()
+	float CrosshairMaxDistanceToCentreADS_DEPRECATED;
+	UPROPERTY()
+	int32 MaxAmmoPerClip_DEPRECATED;
+	UPROPERTY()
+	int32 MaxAmmo_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* ReloadAnimation_DEPRECATED;
+	UPROPERTY()
+	float KillImpluseAmount_DEPRECATED;
+	UPROPERTY()
+	FName WeaponName_DEPRECATED;
+	UPROPERTY()
+	float AIDamageScaler_DEPRECATED;
+#endif
+
+	/** The pawn that has this weapon equipped */
+	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
+	ASCharacterBase* OwningPawn;
+
+	/** What the weapon is currently doing */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
+	EWeaponState WeaponState;
+
+	/** The server's ammo and WeaponState, only marked dirty for replication when one of them changes */
+	UPROPERTY(ReplicatedUsing = OnRep_PackedState)
+	FSWeaponPackedState PackedState;
+
+	/** Whether the owner skipped the last PackedState it received, it is applied by ApplyPackedState() once the owner stops predicting */
+	bool bPackedStateSkipped;
+
+	/** The name of the muzzle socket on the Mesh */
+	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FName MuzzleSocketName;
+
+	/** Persistent component playing the MuzzleEffect, created on the first shot and restarted for every shot after */
+	UPROPERTY(Transient)
+	UParticleSystemComponent* MuzzleEffectComponent;
+
+	/** The damage each shot does for the current owner, from the definition's BaseDamage */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
+	float CurrentDamage;
+
+	/** The world time the next shot is due, advanced by TimeBetweenShots for every shot so the rate of fire doesn't depend on the frame rate */
+	float NextShotTime;
+
+	/** The world time of the last frame shots were scheduled in */
+	float LastScheduleTime;
+
+	/** The owner's eye location at LastScheduleTime */
+	FVector LastScheduleEyeLocation;
+
+	/** The owner's eye rotation at LastScheduleTime */
+	FRotator LastScheduleEyeRotation;
+
+	/** The time the last shot was fired */
+	float LastFireTime;
+
+	/** The sequence number of the next shot, used to seed bullet spread so every machine simulates the same shot */
+	uint16 ShotSequence;
+
+	/** The server time to rewind lag compensated targets to for the shot being fired, negative when the shot is not rewound */
+	float ShotRewindTime;
+
+	/** Shots fired by the owning client that the server hasn't acknowledged yet, oldest first. Every one is resent until it is acknowledged */
+	TArray<FSFireInput> PendingFireInputs;
+
+	/** The world time PendingFireInputs were last sent to the server */
+	float LastFireInputSendTime;
+
+	/** The sequence of the last shot the server applied, replicated to the owner to acknowledge every shot up to it */
+	UPROPERTY(ReplicatedUsing = OnRep_LastAckedShotSequence)
+	uint16 LastAckedShotSequence;
+
+	/** The client fire time of the last shot the server applied, clamped to the server's clock */
+	float LastAppliedFireTime;
+
+	/** Shots the server will still apply from the owner, refilled at the rate of fire by the server's clock */
+	float FireRateBudget;
+
+	/** The server time FireRateBudget was last refilled */
+	float LastFireRateBudgetTime;
+
+	/** Derived from the definition's RateOfFire */
+	float TimeBetweenShots;
+	
+	/** The socket the characters left hand will be attached to */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
+	FName GunHandSocket;
+
+	/** The current ammo no in the clip */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
+	int32 CurrentAmmo;
+
+	/** The current ammo in the clip */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
+	int32 CurrentAmmoInClip;
+
+	/** Used to try and fire the weapon */
+	UPROPERTY(BlueprintReadOnly)
+	bool bTryToFire;
+
+	/** Used to try and reload the weapon */
+	bool bPendingReload;
+
+	/** Whether the weapon is hidden in USWeaponPoolSubsystem waiting to be handed out */
+	bool bIsPooled;
+
+public:
+	
+	/** Sets OwningPawn */
+	void SetOwningPawn(ASCharacterBase* Pawn);
+
+	/** Starts scheduling shots every TimeBetweenShots, the first as soon as TimeBetweenShots has passed since the last shot */
+	virtual void StartFire();
+
+	/** Stops scheduling shots */
+	virtual void StopFire();
+
+	/** Returns Mesh */
+	USkeletalMeshComponent* GetMesh();
+
+	/** Tries to reload if possible */
+	void TryReload();
+
+	/** Resets the weapons states/values */
+	void ResetWeaponState();
+
+	/** Starts the owner's reload action with the reload animation selected for this weapon, Reload() is called when it finishes */
+	void PlayReloadAnimation();
+
+	/** Used to call TryReload() on the server if client */
+	UFUNCTION(Server, Reliable)
+	void ServerTryReload();
+
+	/** Reloads the current clip to it's max and takes the ammo away from the CurrentAmmo */
+	void Reload();
+
+	UFUNCTION(BlueprintCallable)
+	void AddToCurrentAmmo(int32 AmountToAdd);
+
+	/** Puts the weapon on the ground as a ground item with its ammo and destroys the actor, server only */
+	void DropWeapon();
+
+	/** Sets the ammo of a weapon spawned from a ground item */
+	void SetAmmo(int32 NewCurrentAmmo, int32 NewCurrentAmmoInClip);
+
+	/** Sets the ammo back to the class defaults */
+	void ResetAmmo();
+
+	/** Clears everything left over from the last owner before the weapon goes back into the pool */
+	virtual void ResetForPool();
+
+	FORCEINLINE bool IsPooled() const { return bIsPooled; }
+
+	FORCEINLINE void SetIsPooled(bool NewIsPooled) { bIsPooled = NewIsPooled; }
+
+	/** Attaches the overlapping weapon to the character */
+	void PickupWeapon(ASCharacterBase* PawnOwner);
+
+	UFUNCTION(BlueprintCallable)
+	void ResetDamage();
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void SetupAttachmentToOwner();
+
+	FORCEINLINE FName GetGunHandSocket() { return GunHandSocket; }
+
+	FORCEINLINE EWeaponState GetWeaponState() { return WeaponState; }
+	
+	float GetKillImpulseAmount() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	FORCEINLINE USkeletalMeshComponent* GetSkeletalMeshComponent() { return Mesh; }
+
+	FName GetWeaponName() const;
+
+	/** Returns Definition, or the default definition if none is set */
+	const USWeaponDefinition* GetDefinition() const;
+
+	/** Plays the fire sound once for the NumShots queued this frame, and the muzzle flash and a recoil impulse for each shot too if bPlayVisuals */
+	void PlayQueuedFireEffect(int32 NumShots, bool bPlayVisuals);
+
+	/** Plays a tracer from the muzzle to TraceEnd, weapons without tracers do nothing */
+	virtual void PlayTracerEffects(FVector TraceEnd);
+
+protected:
+
+	virtual void BeginPlay() override;
+
+#if WITH_EDITORONLY_DATA
+	/** Gives Blueprints saved before weapons had a definition one made from their deprecated settings */
+	virtual void PostLoad() override;
+
+	/** Copies the deprecated settings into NewDefinition */
+	virtual void CopyDeprecatedSettings(USWeaponDefinition* NewDefinition) const;
+#endif
+
+	/** Goes back into the weapon pool instead of being destroyed */
+	virtual void LifeSpanExpired() override;
+
+	/** Schedules the shots due this frame while the weapon is trying to fire */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Collects every shot due since the last frame, with its time and eye transform interpolated across the frame, and hands them to HandleFiring() */
+	void ScheduleShots();
+
+	/** Fires the batch of shots scheduled this frame while the weapon can fire */
+	void HandleFiring(TArrayView<const FSWeaponShot> Shots);
+
+	/** Fires a single shot using a line trace, and plays the corresponding impact effect depending on the Physics Surface hit */
+	virtual void Fire(const FSWeaponShot& Shot);
+
+	/** Returns a shot fired now from the owner's current eyes */
+	FSWeaponShot MakeShotNow() const;
+
+	/** Adds a shot fired by the owning client to PendingFireInputs */
+	void QueueFireInput(uint16 InShotSequence, float ClientFireTime, const FVector& EyeLocation, const FRotator& AimRotation);
+
+	/** Sends every shot the server hasn't acknowledged yet */
+	void SendFireInputs();
+
+	/**
+	* Fires the shots the server hasn't applied yet in order, rewinding targets to the server time the client fired at. Redundant copies of applied shots are skipped
+	* Shots the server's copy of the weapon can't fire, or fired too far from the server's clock or the owner's location, are dropped
+	*/
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerFireInputs(const TArray<FSFireInput>& FireInputs);
+
+	/** Removes the acknowledged shots from PendingFireInputs */
+	UFUNCTION()
+	void OnRep_LastAckedShotSequence();
+
+	/** Queues the selected effects with the USCosmeticEventSubsystem when the weapon is fired */
+	void PlayFireEffect();
+	
+	/** Removes the fire spread additive from the Crosshair */
+	UFUNCTION(BlueprintImplementableEvent)
+	void ResetWeaponFireSpread();
+
+	/** Determines what EWeaponState the weapon is currently in and updates WeaponState */
+	void DetermineWeaponState();
+
+	/** Whether or not the weapon can be fired */
+	bool CanFire();
+
+	/** Whether or not the weapon can be reloaded */
+	bool CanReload();
+
+	/** Copies the ammo and WeaponState into PackedState on the server, marking it dirty if anything changed */
+	void UpdatePackedState();
+
+	/** Applies the server's ammo and WeaponState, unless the owner is still predicting shots or a reload the server hasn't caught up with */
+	UFUNCTION()
+	void OnRep_PackedState();
+
+	/** Applies a PackedState the owner skipped while it was predicting, the server won't send it again unless it changes */
+	void ApplyPackedState();
+};
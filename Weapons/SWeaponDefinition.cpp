@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWeaponDefinition.h"
+#include "Engine/AssetManager.h"
+
+const FPrimaryAssetType USWeaponDefinition::PrimaryAssetType = TEXT("WeaponDefinition");
+const FName USWeaponDefinition::GameplayBundle = TEXT("Gameplay");
+const FName USWeaponDefinition::CosmeticBundle = TEXT("Cosmetic");
+
+USWeaponDefinition::USWeaponDefinition()
+{
+	BaseDamage = 20.f;
+	AIDamageScaler = .3f;
+	RateOfFire = 600.f;
+	KillImpulseAmount = 50000.f;
+
+	RecoilImpulsePitch = 40.f;
+	RecoilImpulseYaw = 15.f;
+	RecoilImpulseScaleADS = .5f;
+
+	MaxAmmo = 999;
+	MaxAmmoPerClip = 30;
+
+	FireCrosshairSpreadAdditive = 20.f;
+	MaxFireCrosshairSpreadAdditive = 60.f;
+	CrosshairMinDistanceToCentre = 50.f;
+	CrosshairMaxDistanceToCentre = 100.f;
+	CrosshairMinDistanceToCentreADS = 15.f;
+	CrosshairMaxDistanceToCentreADS = 45.f;
+}
+
+FPrimaryAssetId USWeaponDefinition::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+void USWeaponDefinition::LoadAssets(bool bIncludeCosmetics) const
+{
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+
+	if (!GameplayHandle.IsValid())
+	{
+		TArray<FSoftObjectPath> Paths;
+		GetBundlePaths(GameplayBundle, Paths);
+		if (Paths.Num() > 0)
+		{
+			GameplayHandle = StreamableManager.RequestAsyncLoad(Paths, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+		}
+	}
+
+	if (bIncludeCosmetics && !CosmeticHandle.IsValid())
+	{
+		TArray<FSoftObjectPath> Paths;
+		GetBundlePaths(CosmeticBundle, Paths);
+		if (Paths.Num() > 0)
+		{
+			CosmeticHandle = StreamableManager.RequestAsyncLoad(Paths);
+		}
+	}
+}
+
+void USWeaponDefinition::GetBundlePaths(FName Bundle, TArray<FSoftObjectPath>& OutPaths) const
+{
+	auto AddPath = [&OutPaths](const FSoftObjectPath& Path)
+	{
+		if (!Path.IsNull())
+		{
+			OutPaths.Add(Path);
+		}
+	};
+
+	if (Bundle == GameplayBundle)
+	{
+		AddPath(ReloadAnimation.ToSoftObjectPath());
+	}
+	else if (Bundle == CosmeticBundle)
+	{
+		AddPath(MuzzleEffect.ToSoftObjectPath());
+		AddPath(TracerEffect.ToSoftObjectPath());
+		AddPath(DefaultImpactEffect.ToSoftObjectPath());
+		AddPath(FleshImpactEffect.ToSoftObjectPath());
+		AddPath(MetalImpactEffect.ToSoftObjectPath());
+		AddPath(BulletHitDecal.ToSoftObjectPath());
+		AddPath(FireSound.ToSoftObjectPath());
+		AddPath(ImpactSoundFlesh.ToSoftObjectPath());
+		AddPath(ImpactSoundMetal.ToSoftObjectPath());
+		AddPath(ImpactSoundDefault.ToSoftObjectPath());
+		AddPath(FireCamShake.ToSoftObjectPath());
+	}
+}
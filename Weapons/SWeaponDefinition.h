@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/StreamableManager.h"
+#include "SWeaponDefinition.generated.h"
+
+class UAnimMontage;
+class UCameraShake;
+class UNiagaraSystem;
+class UParticleSystem;
+class USoundBase;
+
+/**
+* Everything about a weapon that is the same for every instance of it, shared by all of them instead of copied into each actor
+* Animations and effects are soft references in asset bundles, loaded asynchronously through the asset manager by the first weapon to begin play
+* The Gameplay bundle is loaded everywhere, the Cosmetic bundle only on machines that render
+*/
+UCLASS(BlueprintType)
+class COOPHORDE_API USWeaponDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	USWeaponDefinition();
+
+	/** The primary asset type of weapon definitions */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	/** Assets needed by the server as well as clients */
+	static const FName GameplayBundle;
+
+	/** Assets only needed to see and hear the weapon */
+	static const FName CosmeticBundle;
+
+	/** The name of the weapon, used in game */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FName WeaponName;
+
+	/** The DamageType this weapon will cause */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	TSubclassOf<UDamageType> DamageType;
+
+	/** The base damage each shot of the weapon does */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float BaseDamage;
+
+	/** The amount the weapon damage is scaled by when held by an AI */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon, meta = (ClampMin = 0.01f, ClampMax = 1.f))
+	float AIDamageScaler;
+
+	/** RPM - Bullets per minute fired */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float RateOfFire;
+
+	/** The amount of impulse added to an actor when killed by this weapon */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	float KillImpulseAmount;
+
+	/** The maximum ammo for this weapon */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
+	int32 MaxAmmo;
+
+	/** The maximum ammo per clip */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Ammo, meta = (ClampMin = 0.f))
+	int32 MaxAmmoPerClip;
+
+	/** The amount of crosshair spread added when the weapon is fired */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
+	float FireCrosshairSpreadAdditive;
+
+	/** The maximum amount of crosshair spread added when the weapon is fired */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
+	float MaxFireCrosshairSpreadAdditive;
+
+	/** The minimum distance from centre of the screen to the crosshair */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
+	float CrosshairMinDistanceToCentre;
+
+	/** The maximum distance from centre of the screen to the crosshair */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
+	float CrosshairMaxDistanceToCentre;
+
+	/** The minimum distance from centre of the screen to the crosshair when aiming down sights */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
+	float CrosshairMinDistanceToCentreADS;
+
+	/** The maximum distance from centre of the screen to the crosshair when aiming down sights */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Crosshair, meta = (ClampMin = 0.f))
+	float CrosshairMaxDistanceToCentreADS;
+
+	/** Animation played when reloading, its length times the reload on every machine */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (AssetBundles = "Gameplay"))
+	TSoftObjectPtr<UAnimMontage> ReloadAnimation;
+
+	/** The upward kick each shot gives the owner's recoil spring, in degrees per second */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (ClampMin = 0.f))
+	float RecoilImpulsePitch;
+
+	/** The largest sideways kick each shot gives the owner's recoil spring, picked at random either way */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (ClampMin = 0.f))
+	float RecoilImpulseYaw;
+
+	/** The recoil impulse is multiplied by this when the owner is aiming down sights */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (ClampMin = 0.f))
+	float RecoilImpulseScaleADS;
+
+	/** The effect used when the weapon is fired */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UParticleSystem> MuzzleEffect;
+
+	/** Tracer effect used when the weapon is fired */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UNiagaraSystem> TracerEffect;
+
+	/** The default impact effect used when the weapon is fired at something */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UParticleSystem> DefaultImpactEffect;
+
+	/** The default impact effect used when the weapon is fired at the flesh Physical Surface */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UParticleSystem> FleshImpactEffect;
+
+	/** The default impact effect used when the weapon is fired at the metal Physical Surface */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UNiagaraSystem> MetalImpactEffect;
+
+	/** Decal spawned when weapon fires at objects */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UMaterialInterface> BulletHitDecal;
+
+	/** The sound that is play everytime the weapon is shot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Sound, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> FireSound;
+
+	/** The sounds that are played when the weapon's shot hits something */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Sound, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> ImpactSoundFlesh;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Sound, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> ImpactSoundMetal;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Sound, meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> ImpactSoundDefault;
+
+	/** Camera shake used when the weapon is fired */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effects, meta = (AssetBundles = "Cosmetic"))
+	TSoftClassPtr<UCameraShake> FireCamShake;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/** Starts loading the Gameplay bundle, and the Cosmetic bundle when bIncludeCosmetics, unless they have already been requested */
+	void LoadAssets(bool bIncludeCosmetics) const;
+
+protected:
+
+	/** Keeps the Gameplay bundle loaded while the definition is */
+	mutable TSharedPtr<FStreamableHandle> GameplayHandle;
+
+	/** Keeps the Cosmetic bundle loaded while the definition is */
+	mutable TSharedPtr<FStreamableHandle> CosmeticHandle;
+
+	/** Adds the paths of every soft reference tagged with Bundle */
+	void GetBundlePaths(FName Bundle, TArray<FSoftObjectPath>& OutPaths) const;
+};
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWeaponPoolSubsystem.h"
+#include "SWeapon.h"
+#include "SWeaponStats.h"
+
+static int32 WeaponPoolEnabled = 1;
+FAutoConsoleVariableRef CVARWeaponPoolEnabled(
+	TEXT("COOP.WeaponPool"),
+	WeaponPoolEnabled,
+	TEXT("Reuse released weapon actors instead of destroying them and spawning new ones"),
+	ECVF_Default);
+
+static int32 WeaponPoolMaxFree = 64;
+FAutoConsoleVariableRef CVARWeaponPoolMaxFree(
+	TEXT("COOP.WeaponPoolMaxFree"),
+	WeaponPoolMaxFree,
+	TEXT("The most free weapons kept per class, weapons released past this are destroyed"),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdWeaponPoolStats(
+	TEXT("COOP.WeaponPoolStats"),
+	TEXT("Logs the free, spawned, acquired, reused, released and prewarmed weapons of each pooled weapon class"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		USWeaponPoolSubsystem* WeaponPool = World ? World->GetSubsystem<USWeaponPoolSubsystem>() : nullptr;
+		if (WeaponPool)
+		{
+			WeaponPool->LogStats();
+		}
+	}));
+
+void USWeaponPoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &USWeaponPoolSubsystem::OnWorldInitializedActors);
+}
+
+void USWeaponPoolSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+
+	for (const TPair<UClass*, FSWeaponPool>& Pool : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_WeaponPooledWeapons, Pool.Value.FreeWeapons.Num());
+	}
+	Pools.Reset();
+
+	Super::Deinitialize();
+}
+
+ASWeapon* USWeaponPoolSubsystem::AcquireWeapon(TSubclassOf<ASWeapon> WeaponClass, AActor* NewOwner, const FTransform& Transform)
+{
+	if (WeaponClass == nullptr)
+		return nullptr;
+
+	FSWeaponPool& Pool = Pools.FindOrAdd(WeaponClass);
+	Pool.NumAcquired++;
+
+	while (Pool.FreeWeapons.Num() > 0)
+	{
+		ASWeapon* Weapon = Pool.FreeWeapons.Pop(false);
+		DEC_DWORD_STAT(STAT_WeaponPooledWeapons);
+
+		// Destroyed by something else while it was pooled
+		if (Weapon == nullptr || Weapon->IsPendingKillPending())
+			continue;
+
+		Pool.NumReused++;
+
+		Weapon->SetIsPooled(false);
+		Weapon->SetActorTransform(Transform);
+		Weapon->SetOwner(NewOwner);
+		Weapon->SetActorEnableCollision(true);
+		Weapon->SetActorHiddenInGame(false);
+
+		return Weapon;
+	}
+
+	return SpawnWeapon(WeaponClass, NewOwner, Transform);
+}
+
+void USWeaponPoolSubsystem::ReleaseWeapon(ASWeapon* Weapon)
+{
+	if (Weapon == nullptr || Weapon->IsPooled() || Weapon->IsPendingKillPending())
+		return;
+
+	FSWeaponPool& Pool = Pools.FindOrAdd(Weapon->GetClass());
+	if (WeaponPoolEnabled == 0 || Pool.FreeWeapons.Num() >= WeaponPoolMaxFree)
+	{
+		Weapon->Destroy();
+		return;
+	}
+
+	AddToPool(Weapon, Pool);
+	Pool.NumReleased++;
+}
+
+void USWeaponPoolSubsystem::AddToPool(ASWeapon* Weapon, FSWeaponPool& Pool)
+{
+	Weapon->ResetForPool();
+
+	Weapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Weapon->SetOwner(nullptr);
+	Weapon->SetLifeSpan(0.f);
+
+	// Hidden without collision, so it stops being relevant to every connection
+	Weapon->SetActorHiddenInGame(true);
+	Weapon->SetActorEnableCollision(false);
+	Weapon->SetIsPooled(true);
+
+	Pool.FreeWeapons.Add(Weapon);
+	INC_DWORD_STAT(STAT_WeaponPooledWeapons);
+}
+
+void USWeaponPoolSubsystem::PrewarmWeapons(TSubclassOf<ASWeapon> WeaponClass, int32 Count)
+{
+	UWorld* World = GetWorld();
+	if (WeaponClass == nullptr || World == nullptr || World->GetNetMode() == NM_Client || WeaponPoolEnabled == 0)
+		return;
+
+	FSWeaponPool& Pool = Pools.FindOrAdd(WeaponClass);
+	const int32 NumToSpawn = FMath::Min(Count, WeaponPoolMaxFree) - Pool.FreeWeapons.Num();
+
+	for (int32 i = 0; i < NumToSpawn; i++)
+	{
+		ASWeapon* Weapon = SpawnWeapon(WeaponClass, nullptr, FTransform::Identity);
+		if (Weapon == nullptr)
+			break;
+
+		AddToPool(Weapon, Pool);
+		Pool.NumPrewarmed++;
+	}
+}
+
+void USWeaponPoolSubsystem::LogStats() const
+{
+	UE_LOG(LogCoopWeapons, Log, TEXT("Weapon pool is %s, %d weapon classes"), WeaponPoolEnabled ? TEXT("enabled") : TEXT("disabled"), Pools.Num());
+
+	for (const TPair<UClass*, FSWeaponPool>& Pool : Pools)
+	{
+		const FSWeaponPool& Stats = Pool.Value;
+		const float ReuseRate = Stats.NumAcquired > 0 ? 100.f * Stats.NumReused / Stats.NumAcquired : 0.f;
+
+		UE_LOG(LogCoopWeapons, Log, TEXT("  %s: %d free, %d spawned, %d acquired, %d reused (%.1f%%), %d released, %d prewarmed"),
+			*GetNameSafe(Pool.Key), Stats.FreeWeapons.Num(), Stats.NumSpawned, Stats.NumAcquired, Stats.NumReused, ReuseRate, Stats.NumReleased, Stats.NumPrewarmed);
+	}
+}
+
+void USWeaponPoolSubsystem::OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	if (Params.World != GetWorld())
+		return;
+
+	for (const FSWeaponPoolPrewarm& Prewarm : PrewarmClasses)
+	{
+		PrewarmWeapons(Prewarm.WeaponClass.LoadSynchronous(), Prewarm.Count);
+	}
+}
+
+ASWeapon* USWeaponPoolSubsystem::SpawnWeapon(TSubclassOf<ASWeapon> WeaponClass, AActor* NewOwner, const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.Owner = NewOwner;
+
+	ASWeapon* Weapon = GetWorld()->SpawnActor<ASWeapon>(WeaponClass, Transform, SpawnParams);
+	if (Weapon)
+	{
+		Pools.FindOrAdd(WeaponClass).NumSpawned++;
+	}
+
+	return Weapon;
+}
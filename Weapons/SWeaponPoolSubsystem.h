@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/World.h"
+#include "SWeaponPoolSubsystem.generated.h"
+
+class ASWeapon;
+
+/**
+* A weapon class to spawn into the pool as the world loads
+*/
+USTRUCT()
+struct FSWeaponPoolPrewarm
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The weapon class to spawn */
+	UPROPERTY(Config)
+	TSoftClassPtr<ASWeapon> WeaponClass;
+
+	/** How many instances to spawn */
+	UPROPERTY(Config)
+	int32 Count;
+
+	FSWeaponPoolPrewarm()
+		: Count(0)
+	{}
+};
+
+/**
+* The pooled instances of one weapon class
+*/
+USTRUCT()
+struct FSWeaponPool
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Hidden instances ready to be handed out */
+	UPROPERTY(Transient)
+	TArray<ASWeapon*> FreeWeapons;
+
+	/** Instances the pool has spawned */
+	int32 NumSpawned;
+
+	/** Times an instance has been asked for */
+	int32 NumAcquired;
+
+	/** Times an instance was handed out without spawning one */
+	int32 NumReused;
+
+	/** Times an instance has been given back */
+	int32 NumReleased;
+
+	/** Instances spawned straight into the pool by PrewarmWeapons() */
+	int32 NumPrewarmed;
+
+	FSWeaponPool()
+		: NumSpawned(0)
+		, NumAcquired(0)
+		, NumReused(0)
+		, NumReleased(0)
+		, NumPrewarmed(0)
+	{}
+};
+
+/**
+* Per class pools of ASWeapon, so horde waves don't pay for spawning and destroying a weapon actor for every character
+* Released weapons are reset, hidden and have collision disabled, which also stops them being relevant to any connection until they are handed out again
+* Classes listed in PrewarmClasses in the Game config are spawned on the server as the world's actors are initialized
+*/
+UCLASS(Config = Game)
+class COOPHORDE_API USWeaponPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Hands out a weapon of WeaponClass owned by NewOwner at Transform, reusing a pooled one if there is one */
+	ASWeapon* AcquireWeapon(TSubclassOf<ASWeapon> WeaponClass, AActor* NewOwner, const FTransform& Transform);
+
+	/** Resets Weapon and keeps it for the next AcquireWeapon(), or destroys it when the pool is full or disabled */
+	void ReleaseWeapon(ASWeapon* Weapon);
+
+	/** Spawns weapons into the pool until it holds Count free instances of WeaponClass */
+	UFUNCTION(BlueprintCallable, Category = Weapon)
+	void PrewarmWeapons(TSubclassOf<ASWeapon> WeaponClass, int32 Count);
+
+	/** Logs the pool of every class */
+	void LogStats() const;
+
+protected:
+
+	/** Weapon classes spawned into the pool when the world loads */
+	UPROPERTY(Config)
+	TArray<FSWeaponPoolPrewarm> PrewarmClasses;
+
+	/** The pool of each weapon class */
+	UPROPERTY(Transient)
+	TMap<UClass*, FSWeaponPool> Pools;
+
+	FDelegateHandle WorldInitializedActorsHandle;
+
+	/** Prewarms PrewarmClasses once the world's actors are initialized */
+	void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+
+	/** Resets Weapon and adds it to Pool's free weapons */
+	void AddToPool(ASWeapon* Weapon, FSWeaponPool& Pool);
+
+	/** Spawns a new weapon of WeaponClass */
+	ASWeapon* SpawnWeapon(TSubclassOf<ASWeapon> WeaponClass, AActor* NewOwner, const FTransform& Transform);
+};
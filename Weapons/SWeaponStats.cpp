@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SWeaponStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(WeaponChannel);
+
+DEFINE_LOG_CATEGORY(LogCoopWeapons);
+
+DEFINE_STAT(STAT_WeaponHandleFiring);
+DEFINE_STAT(STAT_WeaponFire);
+DEFINE_STAT(STAT_WeaponBuildPellets);
+DEFINE_STAT(STAT_WeaponTracePellets);
+DEFINE_STAT(STAT_WeaponLineTraceShot);
+DEFINE_STAT(STAT_WeaponResolvePellets);
+DEFINE_STAT(STAT_WeaponPlayShotEvent);
+DEFINE_STAT(STAT_WeaponPlayImpactEffects);
+DEFINE_STAT(STAT_WeaponPlayTracerEffects);
+DEFINE_STAT(STAT_WeaponSpawnImpactDecal);
+DEFINE_STAT(STAT_WeaponFlushImpacts);
+DEFINE_STAT(STAT_WeaponFlushCosmetics);
+DEFINE_STAT(STAT_WeaponRecoilUpdate);
+DEFINE_STAT(STAT_WeaponLagCompensationRewind);
+DEFINE_STAT(STAT_WeaponLagCompensationRecord);
+DEFINE_STAT(STAT_WeaponGroundItemQuery);
+
+DEFINE_STAT(STAT_WeaponFireRPCs);
+DEFINE_STAT(STAT_WeaponPellets);
+DEFINE_STAT(STAT_WeaponTraces);
+DEFINE_STAT(STAT_WeaponMuzzleProbes);
+DEFINE_STAT(STAT_WeaponMuzzleProbesBlocked);
+DEFINE_STAT(STAT_WeaponImpactsQueued);
+DEFINE_STAT(STAT_WeaponFXSpawns);
+DEFINE_STAT(STAT_WeaponCosmeticsCulled);
+DEFINE_STAT(STAT_WeaponDecalsPlaced);
+
+DEFINE_STAT(STAT_WeaponLiveImpactFXComponents);
+DEFINE_STAT(STAT_WeaponLiveTracerComponents);
+DEFINE_STAT(STAT_WeaponLiveImpactDecals);
+DEFINE_STAT(STAT_WeaponGroundItems);
+DEFINE_STAT(STAT_WeaponPooledWeapons);
+DEFINE_STAT(STAT_WeaponImpactFXComponentMemory);
+DEFINE_STAT(STAT_WeaponLagCompensationMemory);
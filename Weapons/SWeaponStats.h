@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+* Stats, trace channel and log category shared by the weapons and their subsystems
+* Shown in game with "stat CoopWeapons", and captured by Unreal Insights when the Weapon channel is enabled, e.g. -trace=cpu,weapon
+*/
+DECLARE_STATS_GROUP(TEXT("CoopWeapons"), STATGROUP_CoopWeapons, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(WeaponChannel, COOPHORDE_API);
+
+/** Log category of the weapons and their subsystems */
+COOPHORDE_API DECLARE_LOG_CATEGORY_EXTERN(LogCoopWeapons, Log, All);
+
+/** Counts the scope in STATGROUP_CoopWeapons and traces it as a CPU event on the WeaponChannel */
+#define SCOPE_WEAPON_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, WeaponChannel)
+
+// Stages of firing a shot
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Handle Firing"), STAT_WeaponHandleFiring, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Fire"), STAT_WeaponFire, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Pellets"), STAT_WeaponBuildPellets, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Trace Pellets"), STAT_WeaponTracePellets, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Line Trace Shot"), STAT_WeaponLineTraceShot, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Pellets"), STAT_WeaponResolvePellets, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Play Shot Event"), STAT_WeaponPlayShotEvent, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Play Impact Effects"), STAT_WeaponPlayImpactEffects, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Play Tracer Effects"), STAT_WeaponPlayTracerEffects, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Impact Decal"), STAT_WeaponSpawnImpactDecal, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flush Impacts"), STAT_WeaponFlushImpacts, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flush Cosmetics"), STAT_WeaponFlushCosmetics, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Recoil Update"), STAT_WeaponRecoilUpdate, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Compensation Rewind"), STAT_WeaponLagCompensationRewind, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Compensation Record"), STAT_WeaponLagCompensationRecord, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ground Item Query"), STAT_WeaponGroundItemQuery, STATGROUP_CoopWeapons, COOPHORDE_API);
+
+// Work done per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Fire RPCs"), STAT_WeaponFireRPCs, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pellets"), STAT_WeaponPellets, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_WeaponTraces, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Muzzle Probes"), STAT_WeaponMuzzleProbes, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Muzzle Probes Blocked"), STAT_WeaponMuzzleProbesBlocked, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impacts Queued"), STAT_WeaponImpactsQueued, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("FX Spawns"), STAT_WeaponFXSpawns, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cosmetics Culled"), STAT_WeaponCosmeticsCulled, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Decals Placed"), STAT_WeaponDecalsPlaced, STATGROUP_CoopWeapons, COOPHORDE_API);
+
+// Live objects owned by the weapon systems
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Impact FX Components"), STAT_WeaponLiveImpactFXComponents, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Tracer Components"), STAT_WeaponLiveTracerComponents, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Impact Decals"), STAT_WeaponLiveImpactDecals, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ground Items"), STAT_WeaponGroundItems, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Weapons"), STAT_WeaponPooledWeapons, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Impact FX Components"), STAT_WeaponImpactFXComponentMemory, STATGROUP_CoopWeapons, COOPHORDE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Lag Compensation History"), STAT_WeaponLagCompensationMemory, STATGROUP_CoopWeapons, COOPHORDE_API);